@@ -0,0 +1,48 @@
+#include <Geode/Geode.hpp>
+#include "../src/Config.hpp"
+#include "../src/FlightRecorder.hpp"
+#include "../src/LogArchiver.hpp"
+
+using namespace geode::prelude;
+
+/*
+    Modules the benchmarked sources call into but that aren't timed themselves. Settings are fixed with
+    millisecond timestamps on and metrics and tracing off, the flight recorder behaves as it does before
+    setup and nothing gets archived.
+*/
+
+Config::Config() {
+    m_mod = Mod::get();
+    m_uniquePath = std::filesystem::temp_directory_path() / fmt::format("sobriety-bench-{}", GetCurrentProcessId());
+    m_scriptPath = m_uniquePath / "scripts";
+}
+
+Config* Config::get() {
+    static Config instance;
+    return &instance;
+}
+
+bool Config::shouldLogMillisconds() { return true; }
+bool Config::shouldTrace() { return false; }
+int Config::getMetricsInterval() { return 0; }
+
+const std::filesystem::path& Config::getUniquePath() {
+    return m_uniquePath;
+}
+
+const std::filesystem::path& Config::getScriptPath() {
+    return m_scriptPath;
+}
+
+FlightRecorder* FlightRecorder::get() {
+    static FlightRecorder instance;
+    return &instance;
+}
+
+void FlightRecorder::record(Severity, Mod*, fmt::string_view, fmt::format_args) {}
+void FlightRecorder::record(Severity, Mod*, std::string_view, int64_t, uint32_t) {}
+void FlightRecorder::recordTrace(const char*, const char*, int64_t) {}
+
+LogArchiver::LogArchiver(const std::filesystem::path&, size_t, uintmax_t) {}
+LogArchiver::~LogArchiver() {}
+void LogArchiver::push(const std::filesystem::path&) {}
@@ -0,0 +1,81 @@
+#include <Geode/Geode.hpp>
+#include <cstring>
+#include "../src/Benchmark.hpp"
+#include "../src/Config.hpp"
+
+using namespace geode::prelude;
+using namespace sobriety::benchmark;
+using Case = sobriety::benchmark::Result;
+
+/*
+    The in-process suite's cases (see BenchmarkCases.cpp) run natively against the shims, for timing the
+    pure parts of the mod without a wine prefix or the game. Usage:
+
+        SobrietyBench [--out latest.json] [--baseline baseline.json] [--save-baseline]
+
+    Results are written as JSON in the same shape as the in-process suite's. With a baseline, every case is
+    compared against it and the exit code is 1 if any got more than kRegression slower.
+*/
+int main(int argc, char** argv) {
+    std::filesystem::path outPath = "latest.json";
+    std::filesystem::path baselinePath;
+    bool saveBaseline = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--out") && i + 1 < argc) outPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--baseline") && i + 1 < argc) baselinePath = argv[++i];
+        else if (!std::strcmp(argv[i], "--save-baseline")) saveBaseline = true;
+        else {
+            fmt::print(stderr, "Usage: {} [--out latest.json] [--baseline baseline.json] [--save-baseline]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    (void) utils::file::createDirectoryAll(Config::get()->getUniquePath());
+    thread::setName("Main");
+
+    // there's no cocos loop here, so this thread stands in for the main thread
+    std::vector<Case> results;
+    runFormat(results);
+    runSink(results);
+    runPaths(results);
+    runExplorer(results);
+    runScheduler(results);
+
+    std::optional<matjson::Value> baseline;
+    if (!baselinePath.empty() && !saveBaseline) {
+        auto text = utils::file::readString(baselinePath);
+        auto parsed = text ? matjson::parse(text.unwrap()) : geode::Err(text.unwrapErr());
+        if (parsed) baseline = std::move(parsed).unwrap();
+        else log::warn("No usable baseline at {}, nothing to compare against: {}", baselinePath.string(), parsed.unwrapErr());
+    }
+
+    bool regressed = false;
+    for (const auto& result : results) {
+        auto previous = baseline ? getBaseline(*baseline, result.name) : 0;
+        if (previous <= 0) {
+            fmt::print("{:<28} {:>10.1f} ns/op ({} iterations)\n", result.name, result.nsPerOp, result.iterations);
+            continue;
+        }
+
+        auto change = result.nsPerOp / previous - 1;
+        regressed |= change > kRegression;
+        fmt::print("{:<28} {:>10.1f} ns/op {:+7.1f}%{}\n", result.name, result.nsPerOp, change * 100, change > kRegression ? "  REGRESSED" : "");
+    }
+
+    auto json = toJson(results, "native").dump();
+    if (auto res = utils::file::writeString(outPath, json); !res) {
+        log::error("Failed to write results: {}", res.unwrapErr());
+        return 2;
+    }
+    if (saveBaseline && !baselinePath.empty()) {
+        if (auto res = utils::file::writeString(baselinePath, json); !res) {
+            log::error("Failed to write baseline: {}", res.unwrapErr());
+            return 2;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(Config::get()->getUniquePath(), ec);
+    return regressed ? 1 : 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <windows.h>
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+#include <fmt/std.h>
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <matjson.hpp>
+#include "Result.hpp"
+#include "cocos/base_nodes/CCNode.h"
+#include "loader/Log.hpp"
+#include "loader/Mod.hpp"
+#include "loader/Types.hpp"
+#include "utils/file.hpp"
+
+/*
+    Stand-ins for the parts of Geode the benchmarked sources touch, enough to run them natively on Linux.
+    Nothing here is timed, it only has to behave the same as the real thing.
+*/
+namespace geode {
+    namespace utils::thread {
+        inline thread_local std::string t_name;
+
+        inline void setName(std::string name) { t_name = std::move(name); }
+        inline std::string getName() { return t_name; }
+    }
+
+    namespace utils::string {
+        inline std::string pathToString(const std::filesystem::path& path) { return path.string(); }
+        inline std::wstring utf8ToWide(std::string_view str) { return std::wstring(str.begin(), str.end()); }
+
+        inline std::string& trimIP(std::string& str) {
+            auto isSpace = [](unsigned char c) { return std::isspace(c); };
+            str.erase(std::find_if_not(str.rbegin(), str.rend(), isSpace).base(), str.end());
+            str.erase(str.begin(), std::find_if_not(str.begin(), str.end(), isSpace));
+            return str;
+        }
+
+        inline std::string trim(std::string str) {
+            return std::move(trimIP(str));
+        }
+
+        inline std::vector<std::string> split(const std::string& str, std::string_view separator) {
+            std::vector<std::string> parts;
+            size_t start = 0;
+            size_t end;
+            while ((end = str.find(separator, start)) != std::string::npos) {
+                parts.push_back(str.substr(start, end - start));
+                start = end + separator.size();
+            }
+            parts.push_back(str.substr(start));
+            return parts;
+        }
+    }
+
+    // the benchmark thread stands in for the main thread
+    inline void queueInMainThread(std::function<void()> func) { func(); }
+
+    namespace prelude {
+        using namespace geode;
+        using namespace geode::utils;
+        using namespace cocos2d;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <fmt/format.h>
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+
+namespace geode {
+    template <class T>
+    struct OkValue { T value; };
+
+    struct ErrValue { std::string message; };
+
+    template <class T = std::monostate, class E = std::string>
+    class Result {
+    public:
+        template <class U>
+        Result(OkValue<U>&& ok) : m_value(T(std::move(ok.value))) {}
+        Result(ErrValue&& err) : m_error(std::move(err.message)) {}
+
+        explicit operator bool() const { return m_value.has_value(); }
+        bool isOk() const { return m_value.has_value(); }
+        bool isErr() const { return !m_value.has_value(); }
+
+        T& unwrap() & { return *m_value; }
+        T unwrap() && { return std::move(*m_value); }
+        T unwrapOr(T other) && { return m_value ? std::move(*m_value) : std::move(other); }
+        E unwrapErr() const { return m_error; }
+
+    private:
+        std::optional<T> m_value;
+        E m_error;
+    };
+
+    template <class T>
+    OkValue<std::decay_t<T>> Ok(T&& value) { return {std::forward<T>(value)}; }
+    inline OkValue<std::monostate> Ok() { return {}; }
+
+    inline ErrValue Err(std::string message) { return {std::move(message)}; }
+    template <class... Args>
+    ErrValue Err(fmt::format_string<Args...> format, Args&&... args) {
+        return {fmt::format(format, std::forward<Args>(args)...)};
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <climits>
+
+// just the reference counting and update hook the scheduler uses, the benchmark calls update itself
+namespace cocos2d {
+    struct ccColor3B {
+        unsigned char r;
+        unsigned char g;
+        unsigned char b;
+    };
+
+    class CCNode {
+    public:
+        virtual ~CCNode() = default;
+
+        bool init() { return true; }
+        void onEnter() {}
+        void autorelease() {}
+        void retain() { m_references++; }
+        void release() {
+            if (--m_references == 0) delete this;
+        }
+
+    private:
+        int m_references = 1;
+    };
+
+    class CCScheduler {
+    public:
+        static CCScheduler* get() {
+            static CCScheduler scheduler;
+            return &scheduler;
+        }
+
+        void scheduleUpdateForTarget(CCNode*, int, bool) {}
+        void unscheduleUpdateForTarget(CCNode*) {}
+    };
+}
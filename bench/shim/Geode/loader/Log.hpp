@@ -0,0 +1,27 @@
+#pragma once
+
+#include <fmt/format.h>
+#include <fmt/std.h>
+#include <cstdio>
+#include "Types.hpp"
+
+// straight to stderr, the benchmark only logs setup failures
+namespace geode::log {
+    template <class... Args>
+    void debug(fmt::format_string<Args...>, Args&&...) {}
+
+    template <class... Args>
+    void info(fmt::format_string<Args...> format, Args&&... args) {
+        fmt::print(stderr, "{}\n", fmt::format(format, std::forward<Args>(args)...));
+    }
+
+    template <class... Args>
+    void warn(fmt::format_string<Args...> format, Args&&... args) {
+        fmt::print(stderr, "{}\n", fmt::format(format, std::forward<Args>(args)...));
+    }
+
+    template <class... Args>
+    void error(fmt::format_string<Args...> format, Args&&... args) {
+        fmt::print(stderr, "{}\n", fmt::format(format, std::forward<Args>(args)...));
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <windows.h>
+#include <fmt/format.h>
+#include <filesystem>
+#include <string>
+#include "../cocos/base_nodes/CCNode.h"
+#include "Log.hpp"
+#include "Types.hpp"
+
+namespace geode {
+    class Mod {
+    public:
+        static Mod* get() {
+            static Mod mod;
+            return &mod;
+        }
+
+        std::string getID() const { return "thyrocytes.sobriety"; }
+        std::string getName() const { return "Sobriety"; }
+        bool isLoggingEnabled() const { return true; }
+        Severity getLogLevel() const { return Severity::Debug; }
+        std::filesystem::path getSaveDir() const { return std::filesystem::temp_directory_path() / "sobriety-bench"; }
+    };
+}
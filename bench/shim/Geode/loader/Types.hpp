@@ -0,0 +1,17 @@
+#pragma once
+
+namespace geode {
+    struct Severity {
+        enum {
+            Debug,
+            Info,
+            Warning,
+            Error
+        };
+
+        int m_value;
+
+        Severity(int value = Info) : m_value(value) {}
+        operator int() const { return m_value; }
+    };
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "../Result.hpp"
+
+namespace geode::utils::file {
+    struct FilePickOptions {
+        struct Filter {
+            std::string description;
+            std::unordered_set<std::string> files;
+        };
+
+        std::optional<std::filesystem::path> defaultPath;
+        std::vector<Filter> filters;
+    };
+
+    inline Result<std::string> readString(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return Err("Unable to open {}", path.string());
+        std::stringstream contents;
+        contents << in.rdbuf();
+        return Ok(contents.str());
+    }
+
+    inline Result<> writeString(const std::filesystem::path& path, const std::string& data) {
+        std::ofstream out(path, std::ios::binary);
+        if (!out || !out.write(data.data(), data.size())) return Err("Unable to write {}", path.string());
+        return Ok();
+    }
+
+    inline Result<> createDirectoryAll(const std::filesystem::path& path) {
+        std::error_code ec;
+        std::filesystem::create_directories(path, ec);
+        if (ec) return Err("Unable to create {}", path.string());
+        return Ok();
+    }
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <fmt/format.h>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Geode/Result.hpp"
+
+// builds, dumps and parses documents, enough for Metrics::snapshot and reading a benchmark baseline back
+namespace matjson {
+    class Value {
+    public:
+        static Value object() { return Value(Kind::Object); }
+        static Value array() { return Value(Kind::Array); }
+
+        Value() = default;
+        Value(const std::string& value) : m_text(quote(value)) {}
+        Value(const char* value) : m_text(quote(value)) {}
+        template <class T> requires std::is_arithmetic_v<T>
+        Value(T value) : m_text(fmt::format("{}", value)) {}
+
+        void set(std::string key, Value value) { m_members.emplace_back(std::move(key), std::move(value)); }
+        void push(Value value) { m_members.emplace_back(std::string(), std::move(value)); }
+
+        bool contains(std::string_view key) const {
+            return find(key) != nullptr;
+        }
+
+        // a null value when there's no such member, like matjson
+        const Value& operator[](std::string_view key) const {
+            static const Value null;
+            auto member = find(key);
+            return member ? *member : null;
+        }
+
+        geode::Result<double> asDouble() const {
+            double value = 0;
+            if (m_kind != Kind::Scalar || m_text.empty()) return geode::Err("not a number");
+            auto [end, ec] = std::from_chars(m_text.data(), m_text.data() + m_text.size(), value);
+            if (ec != std::errc() || end != m_text.data() + m_text.size()) return geode::Err("not a number");
+            return geode::Ok(value);
+        }
+
+        std::string dump() const {
+            if (m_kind == Kind::Scalar) return m_text.empty() ? "null" : m_text;
+
+            std::string out(1, m_kind == Kind::Object ? '{' : '[');
+            for (const auto& [key, value] : m_members) {
+                if (out.size() > 1) out += ',';
+                if (m_kind == Kind::Object) out += quote(key) + ':';
+                out += value.dump();
+            }
+            out += m_kind == Kind::Object ? '}' : ']';
+            return out;
+        }
+
+    private:
+        friend class Parser;
+
+        enum class Kind {
+            Scalar,
+            Object,
+            Array
+        };
+
+        explicit Value(Kind kind) : m_kind(kind) {}
+
+        const Value* find(std::string_view key) const {
+            if (m_kind != Kind::Object) return nullptr;
+            for (const auto& [name, value] : m_members) {
+                if (name == key) return &value;
+            }
+            return nullptr;
+        }
+
+        static std::string quote(std::string_view str) {
+            std::string out = "\"";
+            for (char c : str) {
+                if (c == '"' || c == '\\') out += '\\';
+                out += c;
+            }
+            return out + '"';
+        }
+
+        Kind m_kind = Kind::Scalar;
+        // scalars are kept as their JSON text
+        std::string m_text;
+        std::vector<std::pair<std::string, Value>> m_members;
+    };
+
+    // recursive descent over the whole document, \u escapes are kept as written
+    class Parser {
+    public:
+        explicit Parser(std::string_view text) : m_text(text) {}
+
+        bool parse(Value& out) {
+            if (!value(out)) return false;
+            skipSpace();
+            return m_pos == m_text.size();
+        }
+
+    private:
+        void skipSpace() {
+            while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\n' || m_text[m_pos] == '\r' || m_text[m_pos] == '\t')) m_pos++;
+        }
+
+        bool consume(char c) {
+            skipSpace();
+            if (m_pos >= m_text.size() || m_text[m_pos] != c) return false;
+            m_pos++;
+            return true;
+        }
+
+        bool string(std::string& out) {
+            if (!consume('"')) return false;
+            while (m_pos < m_text.size() && m_text[m_pos] != '"') {
+                char c = m_text[m_pos++];
+                if (c == '\\' && m_pos < m_text.size()) {
+                    char escaped = m_text[m_pos++];
+                    switch (escaped) {
+                        case 'n': c = '\n'; break;
+                        case 't': c = '\t'; break;
+                        case 'r': c = '\r'; break;
+                        case 'b': c = '\b'; break;
+                        case 'f': c = '\f'; break;
+                        case 'u': out += "\\u"; continue;
+                        default: c = escaped; break;
+                    }
+                }
+                out += c;
+            }
+            return consume('"');
+        }
+
+        bool value(Value& out) {
+            skipSpace();
+            if (m_pos >= m_text.size()) return false;
+
+            char c = m_text[m_pos];
+            if (c == '{') {
+                m_pos++;
+                out = Value::object();
+                if (consume('}')) return true;
+                do {
+                    std::string key;
+                    Value member;
+                    if (!string(key) || !consume(':') || !value(member)) return false;
+                    out.set(std::move(key), std::move(member));
+                } while (consume(','));
+                return consume('}');
+            }
+            if (c == '[') {
+                m_pos++;
+                out = Value::array();
+                if (consume(']')) return true;
+                do {
+                    Value item;
+                    if (!value(item)) return false;
+                    out.push(std::move(item));
+                } while (consume(','));
+                return consume(']');
+            }
+            if (c == '"') {
+                std::string str;
+                if (!string(str)) return false;
+                out = Value(str);
+                return true;
+            }
+
+            auto start = m_pos;
+            while (m_pos < m_text.size() && std::string_view(",]} \n\r\t").find(m_text[m_pos]) == std::string_view::npos) m_pos++;
+            auto token = m_text.substr(start, m_pos - start);
+            if (token.empty()) return false;
+            out = Value();
+            if (token != "null") out.m_text = token;
+            return true;
+        }
+
+        std::string_view m_text;
+        size_t m_pos = 0;
+    };
+
+    inline geode::Result<Value> parse(std::string_view text) {
+        Value value;
+        if (!Parser(text).parse(value)) return geode::Err("invalid JSON");
+        return geode::Ok(std::move(value));
+    }
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+// the handful of Win32 calls the benchmarked sources make, mapped onto POSIX
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using DWORD = uint32_t;
+using BOOL = int;
+using HANDLE = void*;
+using HMODULE = void*;
+using FARPROC = void*;
+using LPCWSTR = const wchar_t*;
+using ULONG_PTR = uintptr_t;
+
+#define TRUE 1
+#define FALSE 0
+#define CDECL
+#define INFINITE 0xFFFFFFFF
+#define INVALID_HANDLE_VALUE (reinterpret_cast<HANDLE>(static_cast<intptr_t>(-1)))
+#define INVALID_FILE_ATTRIBUTES (static_cast<DWORD>(-1))
+#define GENERIC_READ 0x80000000
+#define GENERIC_WRITE 0x40000000
+#define FILE_APPEND_DATA 0x4
+#define FILE_SHARE_READ 0x1
+#define FILE_SHARE_WRITE 0x2
+#define FILE_SHARE_DELETE 0x4
+#define CREATE_ALWAYS 2
+#define OPEN_EXISTING 3
+#define OPEN_ALWAYS 4
+#define FILE_ATTRIBUTE_NORMAL 0x80
+#define MOVEFILE_REPLACE_EXISTING 0x1
+#define WAIT_OBJECT_0 0
+#define WAIT_TIMEOUT 258
+#define MAXIMUM_WAIT_OBJECTS 64
+#define HANDLE_FLAG_INHERIT 0x1
+#define STD_INPUT_HANDLE (static_cast<DWORD>(-10))
+#define STD_ERROR_HANDLE (static_cast<DWORD>(-12))
+#define STARTF_USESHOWWINDOW 0x1
+#define STARTF_USESTDHANDLES 0x100
+#define SW_HIDE 0
+#define CREATE_NO_WINDOW 0x08000000
+
+namespace shim {
+    struct Event {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool manual = false;
+        bool set = false;
+    };
+
+    inline int toFd(HANDLE handle) {
+        return static_cast<int>(reinterpret_cast<intptr_t>(handle)) - 1;
+    }
+
+    inline HANDLE fromFd(int fd) {
+        return fd < 0 ? INVALID_HANDLE_VALUE : reinterpret_cast<HANDLE>(static_cast<intptr_t>(fd + 1));
+    }
+
+    inline bool isEvent(HANDLE handle) {
+        return reinterpret_cast<uintptr_t>(handle) > 0x10000;
+    }
+
+    // waits on one event, true if it was signalled
+    inline bool wait(Event* event, DWORD ms) {
+        std::unique_lock lock(event->mutex);
+        auto ready = [&] { return event->set; };
+        bool signalled = ms == INFINITE
+            ? (event->cv.wait(lock, ready), true)
+            : event->cv.wait_for(lock, std::chrono::milliseconds(ms), ready);
+        if (signalled && !event->manual) event->set = false;
+        return signalled;
+    }
+}
+
+inline HANDLE CreateEventW(void*, BOOL manual, BOOL initial, void*) {
+    auto event = new shim::Event;
+    event->manual = manual;
+    event->set = initial;
+    return event;
+}
+
+inline BOOL SetEvent(HANDLE handle) {
+    auto event = static_cast<shim::Event*>(handle);
+    {
+        std::lock_guard lock(event->mutex);
+        event->set = true;
+    }
+    event->cv.notify_all();
+    return TRUE;
+}
+
+inline BOOL ResetEvent(HANDLE handle) {
+    auto event = static_cast<shim::Event*>(handle);
+    std::lock_guard lock(event->mutex);
+    event->set = false;
+    return TRUE;
+}
+
+inline DWORD WaitForSingleObject(HANDLE handle, DWORD ms) {
+    return shim::wait(static_cast<shim::Event*>(handle), ms) ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
+}
+
+// polls, only the reactor waits on more than one handle and it isn't what's being timed
+inline DWORD WaitForMultipleObjectsEx(DWORD count, const HANDLE* handles, BOOL, DWORD ms, BOOL) {
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms == INFINITE ? 3600000 : ms);
+    while (true) {
+        for (DWORD i = 0; i < count; i++) {
+            auto event = static_cast<shim::Event*>(handles[i]);
+            std::lock_guard lock(event->mutex);
+            if (!event->set) continue;
+            if (!event->manual) event->set = false;
+            return WAIT_OBJECT_0 + i;
+        }
+        if (std::chrono::steady_clock::now() >= end) return WAIT_TIMEOUT;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+inline DWORD WaitForMultipleObjects(DWORD count, const HANDLE* handles, BOOL all, DWORD ms) {
+    return WaitForMultipleObjectsEx(count, handles, all, ms, FALSE);
+}
+
+inline HANDLE CreateFileW(const char* path, DWORD access, DWORD, void*, DWORD disposition, DWORD, void*) {
+    int flags = access & (GENERIC_WRITE | FILE_APPEND_DATA) ? O_RDWR : O_RDONLY;
+    if (access == FILE_APPEND_DATA) flags = O_WRONLY | O_APPEND;
+    if (disposition == CREATE_ALWAYS || disposition == OPEN_ALWAYS) flags |= O_CREAT;
+    if (disposition == CREATE_ALWAYS) flags |= O_TRUNC;
+    return shim::fromFd(open(path, flags, 0644));
+}
+
+inline BOOL WriteFile(HANDLE handle, const void* data, DWORD size, DWORD* written, void*) {
+    auto result = write(shim::toFd(handle), data, size);
+    if (result < 0) return FALSE;
+    *written = static_cast<DWORD>(result);
+    return TRUE;
+}
+
+inline BOOL ReadFile(HANDLE handle, void* data, DWORD size, DWORD* read, void*) {
+    auto result = ::read(shim::toFd(handle), data, size);
+    if (result < 0) return FALSE;
+    *read = static_cast<DWORD>(result);
+    return TRUE;
+}
+
+inline BOOL CloseHandle(HANDLE handle) {
+    if (!handle || handle == INVALID_HANDLE_VALUE) return FALSE;
+    if (shim::isEvent(handle)) delete static_cast<shim::Event*>(handle);
+    else close(shim::toFd(handle));
+    return TRUE;
+}
+
+inline DWORD GetFileAttributesW(const char* path) {
+    return access(path, F_OK) == 0 ? FILE_ATTRIBUTE_NORMAL : INVALID_FILE_ATTRIBUTES;
+}
+
+inline BOOL MoveFileExW(const char* from, const char* to, DWORD) {
+    return std::rename(from, to) == 0;
+}
+
+inline DWORD GetLastError() { return static_cast<DWORD>(errno); }
+inline DWORD GetCurrentThreadId() { return static_cast<DWORD>(gettid()); }
+inline DWORD GetCurrentProcessId() { return static_cast<DWORD>(getpid()); }
+
+// no wine here, so PathTranslator falls back to WINEPREFIX and sees the drives a default prefix has
+inline HMODULE GetModuleHandleA(const char*) { return nullptr; }
+inline FARPROC GetProcAddress(HMODULE, const char*) { return nullptr; }
+inline HANDLE GetProcessHeap() { return nullptr; }
+inline BOOL HeapFree(HANDLE, DWORD, void* memory) { std::free(memory); return TRUE; }
+inline DWORD GetLogicalDrives() { return (1u << 2) | (1u << 25); }
+
+// Utils.hpp declares helpers around these, the benchmark never spawns anything
+struct SECURITY_ATTRIBUTES { DWORD nLength; void* lpSecurityDescriptor; BOOL bInheritHandle; };
+struct STARTUPINFOA {
+    DWORD cb; DWORD dwFlags; uint16_t wShowWindow;
+    HANDLE hStdInput; HANDLE hStdOutput; HANDLE hStdError;
+};
+struct PROCESS_INFORMATION { HANDLE hProcess; HANDLE hThread; DWORD dwProcessId; DWORD dwThreadId; };
+
+inline BOOL CreatePipe(HANDLE*, HANDLE*, SECURITY_ATTRIBUTES*, DWORD) { return FALSE; }
+inline BOOL SetHandleInformation(HANDLE, DWORD, DWORD) { return FALSE; }
+inline HANDLE GetStdHandle(DWORD) { return INVALID_HANDLE_VALUE; }
+inline BOOL CreateProcessA(const char*, char*, void*, void*, BOOL, DWORD, void*, const char*, STARTUPINFOA*, PROCESS_INFORMATION*) {
+    return FALSE;
+}
+
+struct EXCEPTION_POINTERS;
+using LPEXCEPTION_POINTERS = EXCEPTION_POINTERS*;
+
+#define CP_UTF8 65001
+
+// widens byte by byte, the benchmark only translates ASCII paths
+inline int MultiByteToWideChar(unsigned, DWORD, const char* str, int size, wchar_t* out, int outSize) {
+    if (outSize == 0) return size;
+    for (int i = 0; i < size && i < outSize; i++) out[i] = static_cast<unsigned char>(str[i]);
+    return std::min(size, outSize);
+}
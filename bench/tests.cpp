@@ -0,0 +1,91 @@
+#include <Geode/Geode.hpp>
+#include "../src/Config.hpp"
+#include "../src/DeferredLog.hpp"
+#include "../src/LogFormatter.hpp"
+#include "../src/LogSink.hpp"
+
+using namespace geode::prelude;
+
+/*
+    Checks for the pure parts of the mod, built against the same shims as the benchmark and run with ctest.
+    Each check prints what it compared when it fails, the exit code is the number of failures.
+*/
+
+static int s_failures = 0;
+
+static void check(bool passed, std::string_view what, std::string_view actual = {}) {
+    if (passed) return;
+    s_failures++;
+    fmt::print(stderr, "FAILED: {}\n", what);
+    if (!actual.empty()) fmt::print(stderr, "  got: {:?}\n", actual);
+}
+
+// the same choice vlogImpl_h makes, deferred when the line can be captured and formatted right away otherwise
+static void logLine(LogSink& sink, Severity severity, fmt::string_view format, fmt::format_args args) {
+    if (sink.appendDeferred(severity, Mod::get(), format, args)) return;
+    sink.append(LogFormatter::format(severity, Mod::get(), format, args), severity, Mod::get());
+}
+
+static std::string_view messageOf(std::string_view line) {
+    auto start = line.find("]: ");
+    if (start == std::string_view::npos) return {};
+    line.remove_prefix(start + 3);
+    if (line.ends_with('\n')) line.remove_suffix(1);
+    return line;
+}
+
+static void testDeferredRender() {
+    int level = 42;
+    std::string_view name = "MenuLayer";
+    auto record = std::string(DeferredLog::capture(Severity::Info, Mod::get(), "Loaded level {} from {}", fmt::make_format_args(level, name)));
+    check(!record.empty(), "positional arguments are captured");
+
+    fmt::memory_buffer buffer;
+    auto rendered = DeferredLog::render(buffer, record);
+    check(rendered.message == "Loaded level 42 from MenuLayer", "a captured line renders its message", rendered.message);
+}
+
+static void testNamedArguments() {
+    int level = 42;
+    std::string_view name = "MenuLayer";
+    auto named = fmt::make_format_args(fmt::arg("level", level), fmt::arg("name", name));
+
+    check(DeferredLog::capture(Severity::Info, Mod::get(), "Loaded level {level} from {name}", named).empty(), "named fields aren't captured");
+    check(DeferredLog::capture(Severity::Info, Mod::get(), "{{level}} {}", named).size() > 0, "escaped braces aren't named fields");
+
+    double value = 3.14159;
+    int precision = 2;
+    auto nested = fmt::make_format_args(value, fmt::arg("precision", precision));
+    check(DeferredLog::capture(Severity::Info, Mod::get(), "{:.{precision}f}", nested).empty(), "nested named fields aren't captured");
+
+    auto path = Config::get()->getUniquePath() / "named.ansi";
+    {
+        LogSink sink({LogTarget{path, LogTarget::Kind::File}});
+        logLine(sink, Severity::Info, "Loaded level {level} from {name}", named);
+        logLine(sink, Severity::Info, "Pi is about {:.{precision}f}", nested);
+        check(sink.flushAndWait(), "the sink flushes");
+    }
+
+    auto text = utils::file::readString(path).unwrapOr("");
+    auto lines = utils::string::split(text, "\n");
+    check(lines.size() == 3, "both lines are written", text);
+    if (lines.size() == 3) {
+        check(messageOf(lines[0]) == "Loaded level 42 from MenuLayer", "named arguments render through the sink", lines[0]);
+        check(messageOf(lines[1]) == "Pi is about 3.14", "nested named arguments render through the sink", lines[1]);
+    }
+    check(text.find("Failed to render") == std::string::npos, "no line fails to render", text);
+}
+
+int main() {
+    (void) utils::file::createDirectoryAll(Config::get()->getUniquePath());
+    thread::setName("Main");
+
+    testDeferredRender();
+    testNamedArguments();
+
+    std::error_code ec;
+    std::filesystem::remove_all(Config::get()->getUniquePath(), ec);
+
+    if (s_failures == 0) fmt::print("All checks passed\n");
+    return s_failures;
+}
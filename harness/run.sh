@@ -0,0 +1,292 @@
+#!/bin/bash
+
+# Times the bash side of the mod headless. The openFile and openConsole scripts are pulled straight out of
+# the sources and run against the stubs in stubs/, which go first on PATH in place of zenity, kdialog, yad
+# and xterm. Nothing here needs wine, a display or the game.
+#
+#   --picks N               pick round trips per transport (default 200)
+#   --picker NAME           zenity, kdialog or yad (default zenity)
+#   --picker-delays "S..."  seconds the picker waits before answering, cycled through (default "0")
+#   --lines N               lines sent to the terminal per transport (default 500)
+#   --heartbeat-seconds N   how long to watch the heartbeat (default 5)
+#   --rate HZ               heartbeat rate handed to the console script (default 20)
+#   --exits N               times the terminal is closed under the console script (default 10)
+#   --out FILE              also write the results in the shape of the mod's metrics.json
+#
+# Results use the same names as the mod's own histograms so the two can be read side by side. The mod's
+# numbers also include wine and the file watcher, these are the floor underneath them. Waiting is done by
+# polling every half millisecond, which is about the resolution of everything here.
+
+set -u
+
+HERE="$(cd "$(dirname "$0")" && pwd)"
+ROOT="$(dirname "$HERE")"
+
+PICKS=200
+PICKER=zenity
+PICKER_DELAYS="0"
+LINES=500
+HEARTBEAT_SECONDS=5
+RATE=20
+EXITS=10
+OUT=""
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --picks) PICKS="$2"; shift ;;
+        --picker) PICKER="$2"; shift ;;
+        --picker-delays) PICKER_DELAYS="$2"; shift ;;
+        --lines) LINES="$2"; shift ;;
+        --heartbeat-seconds) HEARTBEAT_SECONDS="$2"; shift ;;
+        --rate) RATE="$2"; shift ;;
+        --exits) EXITS="$2"; shift ;;
+        --out) OUT="$2"; shift ;;
+        *) echo "Unknown option $1" >&2; exit 2 ;;
+    esac
+    shift
+done
+
+WORK="$(mktemp -d "${TMPDIR:-/tmp}/sobriety-harness.XXXXXX")"
+SAMPLES="$WORK/samples"
+mkdir -p "$SAMPLES"
+
+cleanup() {
+    jobs -p | xargs -r kill 2>/dev/null
+    rm -rf "$WORK"
+}
+trap cleanup EXIT
+
+# Only the stub for the chosen picker goes on PATH, the script prefers kdialog over zenity over yad
+mkdir -p "$WORK/bin"
+ln -s "$HERE/stubs/$PICKER" "$WORK/bin/$PICKER"
+export PATH="$WORK/bin:$PATH"
+export SOBRIETY_TERMINAL="$HERE/stubs/xterm"
+export STUB_TERMINAL_PIDFILE="$WORK/terminal.pid"
+export STUB_TERMINAL_LOG="$SAMPLES/terminal"
+export STUB_PICKER_FILES="/tmp/sobriety-harness/a.gmd:/tmp/sobriety-harness/b.gmd"
+unset XDG_CURRENT_DESKTOP
+
+# the nth R"script( raw string in a source file
+extractScript() {
+    awk -v want="$2" '
+        /^\)script";$/ { if (n == want) exit; inside = 0 }
+        inside && n == want { print }
+        /^R"script\(/ { n++; inside = 1; if (n == want) print substr($0, 10) }
+    ' "$1"
+}
+
+extractScript "$ROOT/src/FileExplorer.cpp" 1 > "$WORK/openFile.sh"
+extractScript "$ROOT/src/Console.cpp" 1 > "$WORK/openConsole.sh"
+
+exec {SLEEP_FD}<> <(:)
+
+now() {
+    REPLY=${EPOCHREALTIME//[^0-9]/}
+}
+
+nap() {
+    read -t 0.0005 -u "$SLEEP_FD"
+}
+
+isRunning() {
+    local stat
+    read -r stat 2>/dev/null < "/proc/$1/stat" || return 1
+    stat=${stat##*) }
+    [ "${stat%% *}" != "Z" ]
+}
+
+# name, labels, then microsecond samples on stdin, one per line
+summarize() {
+    sort -n | awk -v name="$1" -v labels="$2" '
+        { v[NR] = $1; sum += $1 }
+        END {
+            if (NR == 0) exit
+            p50 = v[int((NR - 1) * 0.50) + 1]
+            p99 = v[int((NR - 1) * 0.99) + 1]
+            printf "%s %s %d %.6f %.6f %.6f %.6f\n", name, labels, NR, sum / 1e6, p50 / 1e6, p99 / 1e6, v[NR] / 1e6
+        }
+    ' >> "$WORK/results"
+}
+
+pickRoundTrips() {
+    local delays=($PICKER_DELAYS) dir="$WORK/pick" start i
+    mkdir -p "$dir"
+
+    : > "$SAMPLES/pick-file"
+    : > "$SAMPLES/pick-pipe"
+
+    for ((i = 0; i < PICKS; i++)); do
+        export STUB_PICKER_DELAY="${delays[i % ${#delays[@]}]}"
+
+        # the game waits for selectedFile.txt to be written, the script empties it first
+        now; start=$REPLY
+        bash "$WORK/openFile.sh" "$dir" "$dir" "Select a file" multi "Levels|*.gmd"
+        while [ ! -s "$dir/selectedFile.txt" ]; do nap; done
+        now; echo $((REPLY - start)) >> "$SAMPLES/pick-file"
+
+        now; start=$REPLY
+        bash "$WORK/openFile.sh" - "$dir" "Select a file" multi "Levels|*.gmd" > /dev/null
+        now; echo $((REPLY - start)) >> "$SAMPLES/pick-pipe"
+    done
+
+    summarize sobriety_picker_round_trip_seconds "picker=$PICKER,transport=file" < "$SAMPLES/pick-file"
+    summarize sobriety_picker_round_trip_seconds "picker=$PICKER,transport=pipe" < "$SAMPLES/pick-pipe"
+}
+
+# starts the console script in $1 with transport $2, leaves its pid in CONSOLE_PID
+startConsole() {
+    rm -rf "$1"
+    mkdir -p "$1"
+    : > "$1/console.ansi"
+    rm -f "$STUB_TERMINAL_PIDFILE"
+
+    bash "$WORK/openConsole.sh" "$1" 10 "#ffffff" "#000000" "$2" "$RATE" &
+    CONSOLE_PID=$!
+
+    while [ ! -s "$1/heartbeat/console.heartbeat" ] || [ ! -s "$STUB_TERMINAL_PIDFILE" ]; do nap; done
+    [ "$2" = "pipe" ] && while [ ! -p "$1/console.pipe" ]; do nap; done
+}
+
+stopConsole() {
+    touch "$1/console.exit"
+    wait "$CONSOLE_PID" 2>/dev/null
+}
+
+logToTerminal() {
+    local transport="$1" dir="$WORK/console-$1" i fd tries=0
+    startConsole "$dir" "$transport"
+
+    : > "$STUB_TERMINAL_LOG"
+    if [ "$transport" = "pipe" ]; then
+        exec {fd}> "$dir/console.pipe"
+    else
+        exec {fd}>> "$dir/console.ansi"
+    fi
+
+    # spaced out so each line is timed on its own rather than as part of a batch
+    for ((i = 0; i < LINES; i++)); do
+        now; echo "SEND $REPLY" >&"$fd"
+        read -t 0.002 -u "$SLEEP_FD"
+    done
+    exec {fd}>&-
+
+    while [ "$(wc -l < "$STUB_TERMINAL_LOG")" -lt "$LINES" ]; do
+        read -t 0.05 -u "$SLEEP_FD"
+        ((++tries > 100)) && break
+    done
+
+    summarize sobriety_log_to_terminal_seconds "transport=$transport" < "$STUB_TERMINAL_LOG"
+    stopConsole "$dir"
+}
+
+heartbeat() {
+    local dir="$WORK/console-heartbeat" file beat last start end expected gap
+    startConsole "$dir" file
+    file="$dir/heartbeat/console.heartbeat"
+    expected=$((1000000 / RATE))
+
+    : > "$SAMPLES/interval"
+    : > "$SAMPLES/jitter"
+
+    # timing starts on a beat rather than partway through an interval
+    read -r last < "$file"
+    start=""
+    now; end=$((REPLY + HEARTBEAT_SECONDS * 1000000))
+    while [ "$REPLY" -lt "$end" ]; do
+        nap
+        read -r beat < "$file"
+        now
+        [ "$beat" = "$last" ] && continue
+        last=$beat
+        [ -z "$start" ] && { start=$REPLY; continue; }
+
+        gap=$((REPLY - start - expected))
+        echo $((REPLY - start)) >> "$SAMPLES/interval"
+        echo "${gap#-}" >> "$SAMPLES/jitter"
+        start=$REPLY
+    done
+
+    summarize sobriety_heartbeat_interval_seconds "rate=$RATE" < "$SAMPLES/interval"
+    summarize sobriety_heartbeat_jitter_seconds "rate=$RATE" < "$SAMPLES/jitter"
+    stopConsole "$dir"
+}
+
+# The game calls the console gone once the heartbeat has been quiet for its threshold, which never drops
+# below four expected intervals. That floor stands in for it here.
+exitDetection() {
+    local dir="$WORK/console-exit" file beat last lastAt closed scriptDone silence i
+    silence=$((4 * 1000000 / RATE))
+
+    : > "$SAMPLES/script-exit"
+    : > "$SAMPLES/detection"
+
+    for ((i = 0; i < EXITS; i++)); do
+        startConsole "$dir" file
+        file="$dir/heartbeat/console.heartbeat"
+
+        read -r last < "$file"
+        now; lastAt=$REPLY
+        kill "$(< "$STUB_TERMINAL_PIDFILE")"
+        now; closed=$REPLY
+        scriptDone=0
+
+        while true; do
+            nap
+            read -r beat < "$file"
+            now
+            if [ "$beat" != "$last" ]; then
+                last=$beat
+                lastAt=$REPLY
+            fi
+            if [ "$scriptDone" = 0 ] && ! isRunning "$CONSOLE_PID"; then
+                echo $((REPLY - closed)) >> "$SAMPLES/script-exit"
+                scriptDone=1
+            fi
+            if [ $((REPLY - lastAt)) -gt "$silence" ]; then
+                echo $((REPLY - closed)) >> "$SAMPLES/detection"
+                break
+            fi
+        done
+
+        wait "$CONSOLE_PID" 2>/dev/null
+    done
+
+    summarize sobriety_console_script_exit_seconds "rate=$RATE" < "$SAMPLES/script-exit"
+    summarize sobriety_exit_detection_seconds "rate=$RATE" < "$SAMPLES/detection"
+}
+
+: > "$WORK/results"
+
+echo "Picking $PICKS times through $PICKER..."
+pickRoundTrips
+echo "Sending $LINES lines to the terminal..."
+logToTerminal file
+logToTerminal pipe
+echo "Watching the heartbeat for ${HEARTBEAT_SECONDS}s..."
+heartbeat
+echo "Closing the terminal $EXITS times..."
+exitDetection
+
+echo
+while read -r name labels count sum p50 p99 max; do
+    awk -v n="$name{$labels}" -v c="$count" -v a="$p50" -v b="$p99" -v m="$max" \
+        'BEGIN { printf "%s: p50 %.2fms, p99 %.2fms, max %.2fms (%d samples)\n", n, a * 1000, b * 1000, m * 1000, c }'
+done < "$WORK/results"
+
+if [ -n "$OUT" ]; then
+    awk -v time="$(date +%s%3N)" '
+        BEGIN { printf "{\"time\":%s,\"metrics\":[", time }
+        {
+            count = split($2, pairs, ",")
+            labels = ""
+            for (i = 1; i <= count; i++) {
+                split(pairs[i], kv, "=")
+                labels = labels (i > 1 ? "," : "") "\"" kv[1] "\":\"" kv[2] "\""
+            }
+            printf "%s{\"name\":\"%s\",\"labels\":{%s},\"count\":%d,\"sum\":%s,\"p50\":%s,\"p99\":%s,\"max\":%s}",
+                (NR > 1 ? "," : ""), $1, labels, $3, $4, $5, $6, $7
+        }
+        END { print "]}" }
+    ' "$WORK/results" > "$OUT"
+    echo "Wrote $OUT"
+fi
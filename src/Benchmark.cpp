@@ -0,0 +1,72 @@
+#include <Geode/Geode.hpp>
+#include <future>
+#include "Benchmark.hpp"
+
+using namespace geode::prelude;
+
+bool sobriety::benchmark::isEnabled() {
+    return Loader::get()->getLaunchFlag("sobriety-benchmark");
+}
+
+/*
+    latest.json is rewritten every run, baseline.json only when launched with --geode:sobriety-benchmark-baseline.
+    Anything more than kRegression slower than the baseline is called out.
+*/
+static void report(const std::vector<sobriety::benchmark::Result>& results) {
+    using namespace sobriety::benchmark;
+
+    auto dir = Mod::get()->getSaveDir() / "benchmark";
+    (void) utils::file::createDirectoryAll(dir);
+
+    auto baselinePath = dir / "baseline.json";
+    std::optional<matjson::Value> baseline;
+    if (auto text = utils::file::readString(baselinePath)) {
+        if (auto parsed = matjson::parse(text.unwrap())) baseline = parsed.unwrap();
+    }
+
+    for (const auto& result : results) {
+        auto previous = baseline ? getBaseline(*baseline, result.name) : 0;
+
+        if (previous <= 0) {
+            log::info("[benchmark] {}: {:.1f} ns/op ({} iterations)", result.name, result.nsPerOp, result.iterations);
+            continue;
+        }
+
+        auto change = result.nsPerOp / previous - 1;
+        if (change > kRegression) {
+            log::warn("[benchmark] {}: {:.1f} ns/op, {:+.1f}% against the baseline", result.name, result.nsPerOp, change * 100);
+        }
+        else {
+            log::info("[benchmark] {}: {:.1f} ns/op, {:+.1f}% against the baseline", result.name, result.nsPerOp, change * 100);
+        }
+    }
+
+    auto json = toJson(results, Mod::get()->getVersion().toVString()).dump();
+    if (auto res = utils::file::writeString(dir / "latest.json", json); !res) {
+        log::error("Failed to write benchmark results: {}", res.unwrapErr());
+    }
+    if (Loader::get()->getLaunchFlag("sobriety-benchmark-baseline")) {
+        if (auto res = utils::file::writeString(baselinePath, json); !res) {
+            log::error("Failed to write benchmark baseline: {}", res.unwrapErr());
+        }
+        else log::info("[benchmark] Saved as the new baseline");
+    }
+}
+
+void sobriety::benchmark::run() {
+    std::vector<Result> results;
+
+    runFormat(results);
+    runSink(results);
+    runPaths(results);
+    runExplorer(results);
+
+    std::promise<void> done;
+    queueInMainThread([&] {
+        runScheduler(results);
+        done.set_value();
+    });
+    done.get_future().wait();
+
+    report(results);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <matjson.hpp>
+#include <chrono>
+#include <latch>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/*
+    Microbenchmarks for the mod's hot paths, run in-process on the real wine stack when the game is launched
+    with --geode:sobriety-benchmark. Results are written to benchmark/latest.json in the save directory and
+    compared against benchmark/baseline.json.
+
+    The cases live in BenchmarkCases.cpp, which bench/ also builds natively against shims. That's quicker to
+    iterate on, but only the in-process run goes through wine's file layer.
+*/
+namespace sobriety::benchmark {
+    // slower than the baseline by more than this is logged as a regression
+    constexpr double kRegression = 0.1;
+
+    struct Result {
+        std::string name;
+        size_t iterations;
+        double nsPerOp;
+    };
+
+    template <class F>
+    Result measure(std::string name, size_t iterations, F&& func) {
+        for (size_t i = 0; i < iterations / 10; i++) func();
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) func();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        return {std::move(name), iterations, std::chrono::duration<double, std::nano>(elapsed).count() / iterations};
+    }
+
+    /*
+        For contended paths. setup gets a body to call with the operation, every thread runs it iterations
+        times once they're all started, and anything setup does after body returns (joining a writer,
+        flushing) is timed as well.
+    */
+    template <class Setup>
+    Result measureThreads(std::string name, size_t threads, size_t iterations, Setup&& setup) {
+        std::chrono::steady_clock::time_point start;
+
+        setup([&](auto&& func) {
+            std::latch ready(threads + 1);
+            std::vector<std::thread> workers;
+            for (size_t i = 0; i < threads; i++) {
+                workers.emplace_back([&] {
+                    ready.arrive_and_wait();
+                    for (size_t j = 0; j < iterations; j++) func();
+                });
+            }
+
+            ready.arrive_and_wait();
+            start = std::chrono::steady_clock::now();
+            for (auto& worker : workers) worker.join();
+        });
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        auto ops = threads * iterations;
+        return {std::move(name), ops, std::chrono::duration<double, std::nano>(elapsed).count() / ops};
+    }
+
+    bool isEnabled();
+    void run();
+
+    // each appends its cases to results
+    void runFormat(std::vector<Result>& results);
+    void runSink(std::vector<Result>& results);
+    void runPaths(std::vector<Result>& results);
+    void runExplorer(std::vector<Result>& results);
+    // has to be called on the main thread, the scheduler hooks itself into cocos
+    void runScheduler(std::vector<Result>& results);
+
+    matjson::Value toJson(const std::vector<Result>& results, std::string_view version);
+    // the case's ns/op in a document written by toJson, 0 when it has none
+    double getBaseline(const matjson::Value& baseline, const std::string& name);
+}
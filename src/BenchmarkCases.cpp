@@ -0,0 +1,209 @@
+#include <Geode/Geode.hpp>
+#include "Benchmark.hpp"
+#include "Config.hpp"
+#include "DeferredLog.hpp"
+#include "FileExplorer.hpp"
+#include "LogFormatter.hpp"
+#include "LogSink.hpp"
+#include "PathTranslator.hpp"
+#include "Scheduler.hpp"
+#include "Utils.hpp"
+
+using namespace geode::prelude;
+
+/*
+    The cases themselves, shared by the in-process suite and the native build in bench/. Nothing in here
+    may touch the loader or the game, those parts live in Benchmark.cpp.
+*/
+
+/*
+    The formatting path as it was before LogFormatter, kept so the two can be compared on the same machine.
+*/
+static std::string legacyFormat(Severity severity, Mod* mod, fmt::string_view format, fmt::format_args args) {
+    auto time = std::chrono::system_clock::now();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()) % 1000;
+
+    std::string message = fmt::vformat(format, args);
+    std::string threadName = thread::getName();
+    auto tm = sobriety::utils::convertTime(time);
+
+    std::string ret;
+    if (Config::get()->shouldLogMillisconds()) {
+        ret = fmt::format("{:%H:%M:%S}.{:03}", tm, ms.count());
+    }
+    else {
+        ret = fmt::format("{:%H:%M:%S}", tm);
+    }
+
+    switch (severity.m_value) {
+        case Severity::Debug: ret += " DEBUG"; break;
+        case Severity::Info: ret += " INFO "; break;
+        case Severity::Warning: ret += " WARN "; break;
+        case Severity::Error: ret += " ERROR"; break;
+        default: ret += " ?????"; break;
+    }
+
+    if (threadName.empty())
+        ret += fmt::format(" [{}]: ", mod->getName());
+    else
+        ret += fmt::format(" [{}] [{}]: ", threadName, mod->getName());
+
+    ret += message;
+
+    std::string_view sv{ret};
+    size_t colorEnd = sv.find_first_of('[') - 1;
+    return fmt::format("\033[38;5;{}m{}\033[0m{}\n", 33, sv.substr(0, colorEnd), sv.substr(colorEnd));
+}
+
+void sobriety::benchmark::runFormat(std::vector<Result>& results) {
+    constexpr size_t iterations = 200000;
+
+    auto mod = Mod::get();
+    int level = 42;
+    std::string_view name = "MenuLayer";
+    auto args = fmt::make_format_args(level, name);
+    fmt::string_view format = "Loaded level {} from {}";
+
+    size_t bytes = 0;
+
+    results.push_back(measure("format/legacy", iterations, [&] {
+        bytes += legacyFormat(Severity::Info, mod, format, args).size();
+    }));
+    results.push_back(measure("format/single-pass", iterations, [&] {
+        bytes += LogFormatter::format(Severity::Info, mod, format, args).size();
+    }));
+
+    // capture is what the logging thread pays with deferred formatting on, render is the writer's share
+    std::string record(DeferredLog::capture(Severity::Info, mod, format, args));
+    fmt::memory_buffer rendered;
+    results.push_back(measure("format/deferred-capture", iterations, [&] {
+        bytes += DeferredLog::capture(Severity::Info, mod, format, args).size();
+    }));
+    results.push_back(measure("format/deferred-render", iterations, [&] {
+        rendered.clear();
+        DeferredLog::render(rendered, record);
+        bytes += rendered.size();
+    }));
+
+    log::debug("[benchmark] {} bytes formatted", bytes);
+}
+
+/*
+    A sink of its own writing to a scratch file, timed until it's destroyed so what the writer does counts too.
+*/
+void sobriety::benchmark::runSink(std::vector<Result>& results) {
+    constexpr size_t iterations = 50000;
+
+    int level = 42;
+    std::string_view name = "MenuLayer";
+    auto path = Config::get()->getUniquePath() / "benchmark.ansi";
+    std::string line(LogFormatter::format(Severity::Info, Mod::get(), "Loaded level {} from {}", fmt::make_format_args(level, name)));
+
+    for (size_t threads : {1, 4}) {
+        results.push_back(measureThreads(fmt::format("sink/append-{}t", threads), threads, iterations, [&](auto&& body) {
+            LogSink sink({LogTarget{path, LogTarget::Kind::File}}, OverflowPolicy::Block);
+            body([&] { sink.append(line); });
+        }));
+
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+}
+
+void sobriety::benchmark::runPaths(std::vector<Result>& results) {
+    constexpr size_t iterations = 200000;
+
+    size_t bytes = 0;
+    std::filesystem::path winPath = "C:\\users\\steamuser\\Documents\\Levels\\level.gmd";
+    std::string linuxPath = sobriety::utils::wineToLinuxPath(winPath);
+
+    results.push_back(measure("paths/to-linux-cached", iterations, [&] {
+        bytes += sobriety::utils::wineToLinuxPath(winPath).size();
+    }));
+    results.push_back(measure("paths/to-wine-cached", iterations, [&] {
+        bytes += PathTranslator::get()->toWine(linuxPath).native().size();
+    }));
+
+    // more distinct paths than the cache holds, so every lookup misses
+    std::vector<std::filesystem::path> winPaths;
+    for (size_t i = 0; i < 4096; i++) {
+        winPaths.push_back(fmt::format("C:\\users\\steamuser\\Documents\\Levels\\level-{}.gmd", i));
+    }
+    size_t next = 0;
+    results.push_back(measure("paths/to-linux-uncached", iterations, [&] {
+        bytes += sobriety::utils::wineToLinuxPath(winPaths[next++ % winPaths.size()]).size();
+    }));
+
+    log::debug("[benchmark] {} path bytes", bytes);
+}
+
+void sobriety::benchmark::runExplorer(std::vector<Result>& results) {
+    constexpr size_t iterations = 100000;
+
+    std::vector<geode::utils::file::FilePickOptions::Filter> filters = {
+        {"Levels", {"*.gmd", "*.gmd2"}},
+        {"Images", {"*.png", "*.jpg", "*.jpeg"}}
+    };
+
+    std::string selection;
+    for (size_t i = 0; i < 8; i++) {
+        selection += fmt::format("/home/user/Documents/Levels/level-{}.gmd\n", i);
+    }
+
+    size_t count = 0;
+    results.push_back(measure("explorer/extension-strings", iterations, [&] {
+        count += FileExplorer::generateExtensionStrings(filters).size();
+    }));
+    results.push_back(measure("explorer/parse-selection", iterations, [&] {
+        count += FileExplorer::parseSelection(selection)->paths.size();
+    }));
+
+    log::debug("[benchmark] {} explorer results", count);
+}
+
+/*
+    Runs on the main thread since the scheduler hooks itself into cocos. Every task is due every frame,
+    which is the worst case for the heap.
+*/
+void sobriety::benchmark::runScheduler(std::vector<Result>& results) {
+    for (auto [count, label] : {std::pair<size_t, const char*>{10, "10"}, {1000, "1k"}, {100000, "100k"}}) {
+        auto scheduler = Scheduler::create();
+        scheduler->retain();
+
+        size_t calls = 0;
+        std::vector<Scheduler::Handle> handles;
+        for (size_t i = 0; i < count; i++) {
+            handles.push_back(scheduler->schedule([&calls] { calls++; }));
+        }
+
+        results.push_back(measure(fmt::format("scheduler/update-{}", label), std::max<size_t>(20, 2000000 / count), [&] {
+            scheduler->update(0.f);
+        }));
+
+        for (auto handle : handles) scheduler->unschedule(handle);
+        scheduler->release();
+    }
+}
+
+matjson::Value sobriety::benchmark::toJson(const std::vector<Result>& results, std::string_view version) {
+    auto entries = matjson::Value::object();
+    for (const auto& result : results) {
+        auto entry = matjson::Value::object();
+        entry.set("nsPerOp", result.nsPerOp);
+        entry.set("iterations", result.iterations);
+        entries.set(result.name, entry);
+    }
+
+    auto json = matjson::Value::object();
+    json.set("version", std::string(version));
+    json.set("time", std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count());
+    json.set("results", entries);
+    return json;
+}
+
+double sobriety::benchmark::getBaseline(const matjson::Value& baseline, const std::string& name) {
+    if (!baseline["results"].contains(name)) return 0;
+    return baseline["results"][name]["nsPerOp"].asDouble().unwrapOr(0);
+}
@@ -1,6 +1,7 @@
 #include <Geode/Geode.hpp>
 #include "Config.hpp"
 #include "Console.hpp"
+#include "SessionDirectory.hpp"
 #include "Utils.hpp"
 
 using namespace geode::prelude;
@@ -15,16 +16,18 @@ Config::Config() {
     m_mod = Mod::get();
     auto now = std::chrono::system_clock::now();
     auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
-    m_uniquePath = std::filesystem::path(fmt::format("/tmp/GeometryDash-{}/", nowMs));
+    m_sessionName = fmt::format("GeometryDash-{}", nowMs);
+    m_uniquePath = SessionDirectory::resolveBasePath() / fmt::format("{}/", m_sessionName);
+    m_scriptPath = m_mod->getSaveDir() / "scripts";
 }
 
+// read fresh each time, ConsoleFilter caches the result and rebuilds when it changes
 Severity Config::getConsoleLogLevel() {
-    static auto setting = sobriety::utils::fromString(m_geode->getSettingValue<std::string>("console-log-level"));
-    static auto listener = listenForSettingChanges("console-log-level", [this](std::string value) {
-        setting = sobriety::utils::fromString(value);
-    }, m_geode);
+    return sobriety::utils::fromString(m_geode->getSettingValue<std::string>("console-log-level"));
+}
 
-    return setting;
+std::string Config::getConsoleModFilters() {
+    return m_mod->getSettingValue<std::string>("console-mod-filters");
 }
 
 bool Config::shouldLogMillisconds() {
@@ -45,6 +48,11 @@ int Config::getHeartbeatThreshold() {
     return setting;
 }
 
+int Config::getHeartbeatRate() {
+    static auto setting = m_mod->getSettingValue<int>("console-heartbeat-rate");
+    return setting;
+}
+
 int Config::getFontSize() {
     static auto setting = m_mod->getSettingValue<int>("console-font-size");
     return setting;
@@ -104,11 +112,98 @@ cocos2d::ccColor3B Config::getLogDebugColor() {
     return setting;
 }
 
+bool Config::useConsolePipe() {
+    static auto setting = m_mod->getSettingValue<std::string>("console-transport") == "pipe";
+    return setting;
+}
+
+bool Config::usePickerPipe() {
+    static auto setting = m_mod->getSettingValue<bool>("picker-use-pipe");
+    return setting;
+}
+
+bool Config::shouldPersistConsoleLog() {
+    static auto setting = m_mod->getSettingValue<bool>("console-persist-log");
+    return setting;
+}
+
+size_t Config::getConsoleSegmentSize() {
+    static auto setting = m_mod->getSettingValue<int>("console-segment-size");
+    return static_cast<size_t>(setting) * 1024 * 1024;
+}
+
+size_t Config::getConsoleSegmentCount() {
+    static auto setting = m_mod->getSettingValue<int>("console-segment-count");
+    return static_cast<size_t>(setting);
+}
+
+bool Config::shouldIndexConsoleLog() {
+    static auto setting = m_mod->getSettingValue<bool>("console-index");
+    return setting;
+}
+
+OverflowPolicy Config::getConsoleOverflowPolicy() {
+    static auto setting = m_mod->getSettingValue<std::string>("console-overflow-policy");
+    if (setting == "block") return OverflowPolicy::Block;
+    if (setting == "drop-newest") return OverflowPolicy::DropNewest;
+    return OverflowPolicy::DropOldest;
+}
+
+bool Config::shouldDeferFormatting() {
+    static auto setting = m_mod->getSettingValue<bool>("console-deferred-format");
+    return setting;
+}
+
+int Config::getSessionRetention() {
+    static auto setting = m_mod->getSettingValue<int>("session-retention");
+    return setting;
+}
+
+bool Config::shouldTrace() {
+    static auto setting = m_mod->getSettingValue<bool>("trace-enabled");
+    return setting;
+}
+
+bool Config::shouldRecordFlight() {
+    static auto setting = m_mod->getSettingValue<bool>("flight-recorder");
+    return setting;
+}
+
+int Config::getMetricsInterval() {
+    static auto setting = m_mod->getSettingValue<int>("metrics-interval");
+    return setting;
+}
+
+int Config::getStallThreshold() {
+    static auto setting = m_mod->getSettingValue<int>("stall-threshold");
+    return setting;
+}
+
+bool Config::shouldProfile() {
+    static auto setting = m_mod->getSettingValue<bool>("profiler-enabled");
+    return setting;
+}
+
+int Config::getProfilerRate() {
+    static auto setting = m_mod->getSettingValue<int>("profiler-rate");
+    return setting;
+}
+
 bool Config::hasConsole() {
     static bool setting = m_geode->getSettingValue<bool>("show-platform-console");
     return setting;
 }
 
+// the session directory's own name, for anything that has to recognise it among the others
+const std::string& Config::getSessionName() {
+    return m_sessionName;
+}
+
 const std::filesystem::path& Config::getUniquePath() {
     return m_uniquePath;
-}
\ No newline at end of file
+}
+
+// scripts outlive the session so unchanged ones don't have to be written again every launch
+const std::filesystem::path& Config::getScriptPath() {
+    return m_scriptPath;
+}
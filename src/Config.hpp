@@ -2,6 +2,8 @@
 
 #include <Geode/loader/Mod.hpp>
 #include <filesystem>
+#include <string>
+#include "OverflowPolicy.hpp"
 
 class Config {
 public:
@@ -10,10 +12,27 @@ public:
     static Config* get();
 
     geode::Severity getConsoleLogLevel();
+    std::string getConsoleModFilters();
     bool shouldLogMillisconds();
     int getHeartbeatThreshold();
+    int getHeartbeatRate();
     int getFontSize();
     bool hasConsole();
+    bool useConsolePipe();
+    bool usePickerPipe();
+    bool shouldPersistConsoleLog();
+    size_t getConsoleSegmentSize();
+    size_t getConsoleSegmentCount();
+    bool shouldIndexConsoleLog();
+    bool shouldTrace();
+    bool shouldRecordFlight();
+    int getMetricsInterval();
+    int getStallThreshold();
+    bool shouldProfile();
+    int getProfilerRate();
+    OverflowPolicy getConsoleOverflowPolicy();
+    bool shouldDeferFormatting();
+    int getSessionRetention();
     cocos2d::ccColor3B getConsoleForegroundColor();
     cocos2d::ccColor3B getConsoleBackgroundColor();
     cocos2d::ccColor3B getLogInfoColor();
@@ -21,10 +40,14 @@ public:
     cocos2d::ccColor3B getLogErrorColor();
     cocos2d::ccColor3B getLogDebugColor();
 
+    const std::string& getSessionName();
     const std::filesystem::path& getUniquePath();
+    const std::filesystem::path& getScriptPath();
 
 private:
     geode::Mod* m_geode = nullptr;
     geode::Mod* m_mod = nullptr;
+    std::string m_sessionName;
     std::filesystem::path m_uniquePath;
+    std::filesystem::path m_scriptPath;
 };
\ No newline at end of file
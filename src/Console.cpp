@@ -1,9 +1,13 @@
 #include <Geode/Geode.hpp>
 #include "Console.hpp"
-#include "FileAppender.hpp"
+#include "ConsoleFilter.hpp"
+#include "FlightRecorder.hpp"
+#include "LogFormatter.hpp"
+#include "LogSink.hpp"
+#include "Metrics.hpp"
+#include "Tracer.hpp"
 #include "Utils.hpp"
 #include "Config.hpp"
-#include "FileWatcher.hpp"
 
 using namespace geode::prelude;
 
@@ -12,10 +16,20 @@ Console* Console::get() {
     return &instance;
 }
 
+// the process is in an unknown state here, so nothing in this allocates
 static LONG WINAPI exceptionHandler(LPEXCEPTION_POINTERS info) {
-    auto exitPath = Config::get()->getUniquePath() / "console.exit";
-    auto res = utils::file::writeString(exitPath, "");
-    if (!res) log::error("Failed to create console exit file");
+    FlightRecorder::get()->crash(info);
+
+    auto exitFile = CreateFileW(
+        Console::get()->getExitPath().c_str(),
+        GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (exitFile != INVALID_HANDLE_VALUE) CloseHandle(exitFile);
 
     auto originalUEF = Console::get()->getOriginalUEF();
 
@@ -23,47 +37,87 @@ static LONG WINAPI exceptionHandler(LPEXCEPTION_POINTERS info) {
 }
 
 void Console::setup() {
+    TraceSpan span("console", "Console::setup");
     sobriety::utils::createTempDir();
     if (Config::get()->hasConsole()) {
-        auto watcher = FileWatcher::getForDirectory(Config::get()->getUniquePath());
-        watcher->watch("console.heartbeat", [this] {
-            setupHeartbeat();
-        });
-
+        m_exitPath = Config::get()->getUniquePath() / "console.exit";
+        if (Config::get()->shouldRecordFlight()) {
+            FlightRecorder::get()->setup(Config::get()->getUniquePath() / "flight.bin");
+        }
         setupLogFile();
-        setupScript();
+        ConsoleFilter::get()->setup();
         setupHooks();
 
-        FreeConsole();
-        sobriety::utils::runCommand(fmt::format("{}/openConsole.exe {} {} {} {}", Config::get()->getUniquePath(), 
-            Config::get()->getUniquePath(), 
-            Config::get()->getFontSize(), 
-            "#" + cc3bToHexString(Config::get()->getConsoleForegroundColor()), 
-            "#" + cc3bToHexString(Config::get()->getConsoleBackgroundColor())
-        ));
-
         m_originalUEF = SetUnhandledExceptionFilter(exceptionHandler);
     }
 }
 
+/*
+    Spawning through wine takes long enough to be noticeable at launch, so this runs on the startup thread.
+    Anything logged in the meantime waits in the sink, the pipe backlog or the file tail reads from the start.
+*/
+void Console::start() {
+    if (!Config::get()->hasConsole()) return;
+    TraceSpan span("console", "Console::start");
+
+    auto path = setupScript();
+    if (path.empty()) return;
+
+    FreeConsole();
+    auto processRes = sobriety::utils::spawnProcess(fmt::format("{} {} {} {} {} {} {}", path, 
+        Config::get()->getUniquePath(), 
+        Config::get()->getFontSize(), 
+        "#" + cc3bToHexString(Config::get()->getConsoleForegroundColor()), 
+        "#" + cc3bToHexString(Config::get()->getConsoleBackgroundColor()),
+        Config::get()->useConsolePipe() ? "pipe" : "file",
+        Config::get()->getHeartbeatRate()
+    ));
+    if (!processRes) log::error("Failed to open console: {}", processRes.unwrapErr());
+    setupHeartbeat(processRes.unwrapOr(nullptr));
+
+    bool hasLogFile = !Config::get()->useConsolePipe() || Config::get()->shouldPersistConsoleLog();
+    if (hasLogFile && Config::get()->shouldIndexConsoleLog()) setupQueryScript();
+}
+
 LPTOP_LEVEL_EXCEPTION_FILTER Console::getOriginalUEF() {
     return m_originalUEF;
 }
 
+const std::filesystem::path& Console::getExitPath() {
+    return m_exitPath;
+}
+
 void Console::setConsoleColors() {
 
-    auto appender = Console::get()->getLogAppender();
-    if (appender) {
-        appender->append(fmt::format("\033]10;#{}\007", cc3bToHexString(Config::get()->getConsoleForegroundColor())));
-        appender->append(fmt::format("\033]11;#{}\007", cc3bToHexString(Config::get()->getConsoleBackgroundColor())));
+    auto sink = Console::get()->getLogSink();
+    if (sink) {
+        // sent through the error lane so a log flood can't drop them
+        sink->append(fmt::format("\033]10;#{}\007", cc3bToHexString(Config::get()->getConsoleForegroundColor())), Severity::Error);
+        sink->append(fmt::format("\033]11;#{}\007", cc3bToHexString(Config::get()->getConsoleBackgroundColor())), Severity::Error);
 
-        appender->append(fmt::format("\033]4;33;#{}\007", cc3bToHexString(Config::get()->getLogInfoColor())));
-        appender->append(fmt::format("\033]4;229;#{}\007", cc3bToHexString(Config::get()->getLogWarnColor())));
-        appender->append(fmt::format("\033]4;9;#{}\007", cc3bToHexString(Config::get()->getLogErrorColor())));
-        appender->append(fmt::format("\033]4;243;#{}\007", cc3bToHexString(Config::get()->getLogDebugColor())));
+        sink->append(fmt::format("\033]4;33;#{}\007", cc3bToHexString(Config::get()->getLogInfoColor())), Severity::Error);
+        sink->append(fmt::format("\033]4;229;#{}\007", cc3bToHexString(Config::get()->getLogWarnColor())), Severity::Error);
+        sink->append(fmt::format("\033]4;9;#{}\007", cc3bToHexString(Config::get()->getLogErrorColor())), Severity::Error);
+        sink->append(fmt::format("\033]4;243;#{}\007", cc3bToHexString(Config::get()->getLogDebugColor())), Severity::Error);
     
-        appender->append("\033[A\033[B"); // forces a refresh
+        sink->append("\033[A\033[B", Severity::Error); // forces a refresh
+        sink->flush();
+    }
+}
+
+// each thread keeps its own pointers to the counters so counting a line never touches the registry lock
+static void countLine(Severity severity, Mod* mod) {
+    static constexpr std::array<const char*, LogSink::kLaneCount> names = {"debug", "info", "warning", "error"};
+    thread_local std::unordered_map<Mod*, std::array<Metrics::Counter*, LogSink::kLaneCount>> cache;
+
+    auto lane = static_cast<size_t>(std::clamp<int>(severity.m_value, 0, LogSink::kLaneCount - 1));
+    auto& counters = cache[mod];
+    if (!counters[lane]) {
+        counters[lane] = &Metrics::get()->counter("sobriety_log_lines_total", "Lines logged that passed the console filter",
+            {{"mod", mod->getID()}, {"severity", names[lane]}}
+        );
     }
+    counters[lane]->add();
 }
 
 /*
@@ -71,51 +125,26 @@ void Console::setConsoleColors() {
     have nesting support yet, I really could care less adding that back, but probably will at some point.
 */
 void vlogImpl_h(Severity severity, Mod* mod, fmt::string_view format, fmt::format_args args) {
+    TraceSpan span("log", "vlogImpl");
     log::vlogImpl(severity, mod, format, args);
 
     if (!mod->isLoggingEnabled()) return;
     if (severity < mod->getLogLevel()) return;
-    if (severity < Config::get()->getConsoleLogLevel()) return;
-
-    auto time = std::chrono::system_clock::now();
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()) % 1000;
-
-    Log log {
-        mod,
-        severity,
-        fmt::vformat(format, args),
-        thread::getName(),
-        sobriety::utils::convertTime(time),
-        ms.count()
-    };
-
-    int color = 0;
-    switch (severity) {
-        case Severity::Debug:
-            color = 243;
-            break;
-        case Severity::Info:
-            color = 33;
-            break;
-        case Severity::Warning:
-            color = 229;
-            break;
-        case Severity::Error:
-            color = 9;
-            break;
-        default:
-            color = 7;
-            break;
-    }
-    
-    std::string_view sv{Console::get()->buildLog(log)};
+    if (!ConsoleFilter::get()->isAccepted(mod, severity)) return;
+    countLine(severity, mod);
 
-    size_t colorEnd = sv.find_first_of('[') - 1;
+    // the recorder is handed whatever text the sink ends up with, see FlightRecorder
+    auto sink = Console::get()->getLogSink();
+    if (!sink || !sink->isAccepting(severity)) {
+        return FlightRecorder::get()->record(severity, mod, format, args);
+    }
 
-    auto str = fmt::format("\033[38;5;{}m{}\033[0m{}\n", color, sv.substr(0, colorEnd), sv.substr(colorEnd));
+    if (Config::get()->shouldDeferFormatting() && sink->appendDeferred(severity, mod, format, args)) return;
 
-    auto appender = Console::get()->getLogAppender();
-    if (appender) appender->append(str);
+    size_t messageStart;
+    auto line = LogFormatter::format(severity, mod, format, args, &messageStart);
+    FlightRecorder::get()->record(severity, mod, line.substr(messageStart, line.size() - messageStart - 1));
+    sink->append(line, severity, mod);
 }
 
 void Console::setupHooks() {
@@ -127,14 +156,40 @@ void Console::setupHooks() {
 }
 
 void Console::setupLogFile() {
-    auto path = Config::get()->getUniquePath() / "console.ansi";;
-    auto res = utils::file::writeString(path, "");
-    if (!res) return log::error("Failed to create console ansi file");
+    std::vector<LogTarget> targets;
 
-    m_logAppender = std::make_shared<FileAppender>(path);
+    if (Config::get()->useConsolePipe()) {
+        targets.push_back({Config::get()->getUniquePath() / "console.pipe", LogTarget::Kind::Pipe});
+    }
+
+    if (!Config::get()->useConsolePipe() || Config::get()->shouldPersistConsoleLog()) {
+        auto path = Config::get()->getUniquePath() / "console.ansi";
+        auto res = utils::file::writeString(path, "");
+        if (!res) log::error("Failed to create console ansi file");
+        else targets.push_back({
+            path,
+            LogTarget::Kind::File,
+            Config::get()->getConsoleSegmentSize(),
+            Config::get()->getConsoleSegmentCount(),
+            Config::get()->shouldIndexConsoleLog()
+        });
+    }
+
+    if (targets.empty()) return;
+
+    m_logSink = std::make_shared<LogSink>(std::move(targets), Config::get()->getConsoleOverflowPolicy());
+
+    Metrics::get()->observe("sobriety_sink_queue_depth", "Lines waiting for the sink's writer", [] {
+        auto sink = Console::get()->getLogSink();
+        return sink ? static_cast<double>(sink->getQueueDepth()) : 0.0;
+    });
+    Metrics::get()->observe("sobriety_sink_pending_bytes", "Bytes waiting for the sink's writer", [] {
+        auto sink = Console::get()->getLogSink();
+        return sink ? static_cast<double>(sink->getPendingBytes()) : 0.0;
+    });
 }
 
-void Console::setupScript() {
+std::filesystem::path Console::setupScript() {
     static std::string script = 
 R"script(#!/bin/bash
 
@@ -142,120 +197,330 @@ UNIQUE_PATH="${1}"
 FONT_SIZE="${2:-10}"
 FG_COLOR="${3:-#ffffff}"
 BG_COLOR="${4:-#000000}"
+TRANSPORT="${5:-file}"
+HEARTBEAT_RATE="${6:-20}"
 
 CONSOLE_FILE="$UNIQUE_PATH/console.ansi"
-HEARTBEAT_FILE="$UNIQUE_PATH/console.heartbeat"
+CONSOLE_PIPE="$UNIQUE_PATH/console.pipe"
+HEARTBEAT_DIR="$UNIQUE_PATH/heartbeat"
+HEARTBEAT_FILE="$HEARTBEAT_DIR/console.heartbeat"
+CPU_FILE="$HEARTBEAT_DIR/console.cpu"
 EXIT_FILE="$UNIQUE_PATH/console.exit"
 
-/usr/bin/xterm \
+# The fifo is opened read-write before it is moved into place, so the game never sees it without a reader
+# and its open can't block. Holding it here also keeps the reader from seeing EOF between writers.
+if [ "$TRANSPORT" = "pipe" ] && mkfifo "$CONSOLE_PIPE.tmp"; then
+    exec 3<>"$CONSOLE_PIPE.tmp"
+    mv "$CONSOLE_PIPE.tmp" "$CONSOLE_PIPE"
+    FOLLOW=(cat "$CONSOLE_PIPE")
+else
+    FOLLOW=(tail -n +1 -F "$CONSOLE_FILE")
+fi
+
+"${SOBRIETY_TERMINAL:-/usr/bin/xterm}" \
   -fa "Monospace" \
   -bg "$BG_COLOR" \
   -fg "$FG_COLOR" \
   -T "Geometry Dash" \
   -fs "$FONT_SIZE" \
   -xrm "XTerm*VT100.Translations: #override Ctrl Shift <Key>C: copy-selection(CLIPBOARD)" \
-  -e tail -F "$CONSOLE_FILE" &
+  -e "${FOLLOW[@]}" &
 
 TERM_PID=$!
 
+# Everything in the loop is a builtin so a beat never forks. read -t on a pipe nobody writes to stands in for
+# sleep, and the counter is rewritten in place at a fixed width so the game can keep it mapped.
+# It lives in its own directory so the game's watcher on UNIQUE_PATH isn't woken by every beat.
+exec {SLEEP_FD}<> <(:)
+INTERVAL_US=$((1000000 / HEARTBEAT_RATE))
+printf -v INTERVAL '%d.%06d' $((INTERVAL_US / 1000000)) $((INTERVAL_US % 1000000))
+
+# CPU time of this script, the terminal and whatever the terminal runs, in milliseconds, for the game's metrics.
+# The command name in stat can hold spaces, so the fields are counted from after it.
+CLK_TCK=$(getconf CLK_TCK 2>/dev/null || echo 100)
+CPU_EVERY=$((HEARTBEAT_RATE * 5))
+
+cpuTime() {
+    local stat fields
+    REPLY=0
+    read -r stat 2>/dev/null < "/proc/$1/stat" || return
+    fields=(${stat##*) })
+    REPLY=$(( (fields[11] + fields[12]) * 1000 / CLK_TCK ))
+}
+
+writeCpu() {
+    local children child follow=0
+    cpuTime $$; local script=$REPLY
+    cpuTime "$TERM_PID"; local terminal=$REPLY
+    read -r children 2>/dev/null < "/proc/$TERM_PID/task/$TERM_PID/children"
+    for child in $children; do
+        cpuTime "$child"; follow=$((follow + REPLY))
+    done
+    printf 'script %d\nterminal %d\nfollow %d\n' "$script" "$terminal" "$follow" > "$CPU_FILE"
+}
+
+BEAT=0
+mkdir -p "$HEARTBEAT_DIR"
+printf '%020d' "$BEAT" > "$HEARTBEAT_FILE"
+
 while [ ! -f "$EXIT_FILE" ]; do
     if ! kill -0 "$TERM_PID" 2>/dev/null; then
         break
     fi
 
-    date +%s%3N > "$HEARTBEAT_FILE"
-    sleep 0.016667
+    BEAT=$((BEAT + 1))
+    printf '%020d' "$BEAT" 1<> "$HEARTBEAT_FILE"
+    [ $((BEAT % CPU_EVERY)) -eq 0 ] && writeCpu
+    read -t "$INTERVAL" -u "$SLEEP_FD"
 done
 
 kill "$TERM_PID" 2>/dev/null
-rm -f "$EXIT_FILE"
+rm -f "$EXIT_FILE" "$CONSOLE_PIPE"
+
+)script";
+
+    auto res = sobriety::utils::emitScript("openConsole", script);
+    if (!res) {
+        log::error("Failed to create openConsole script: {}", res.unwrapErr());
+        return {};
+    }
+    return res.unwrap();
+}
+
+/*
+    Written next to the log rather than into the scripts directory, it's meant to be run by hand from there.
+*/
+void Console::setupQueryScript() {
+    static std::string script = 
+R"script(#!/bin/bash
+
+# Prints lines from this session's console log. The matching range is found by binary searching the index
+# the game keeps next to the log, so only that part of console.ansi is ever read.
+#
+#   --severity debug|info|warn|error   only lines at or above this severity
+#   --mod <id>                         only lines from this mod, can be given more than once
+#   --since <time>, --until <time>     anything date -d understands, like 14:02 or "10 minutes ago"
+#   --plain                            strip colours
+
+DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+LOG="$DIR/console.ansi"
+INDEX="$DIR/console.idx"
+MODS="$DIR/console.mods"
+RECORD=24
+
+MIN_SEVERITY=0
+SINCE=""
+UNTIL=""
+PLAIN=0
+MOD_NAMES=()
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --severity)
+            case "$2" in
+                debug) MIN_SEVERITY=0 ;;
+                info) MIN_SEVERITY=1 ;;
+                warn|warning) MIN_SEVERITY=2 ;;
+                error) MIN_SEVERITY=3 ;;
+                *) echo "Unknown severity: $2" >&2; exit 1 ;;
+            esac
+            shift 2 ;;
+        --mod) MOD_NAMES+=("$2"); shift 2 ;;
+        --since) SINCE=$(date -d "$2" +%s%3N) || exit 1; shift 2 ;;
+        --until) UNTIL=$(date -d "$2" +%s%3N) || exit 1; shift 2 ;;
+        --plain) PLAIN=1; shift ;;
+        *) echo "Unknown option: $1" >&2; exit 1 ;;
+    esac
+done
 
+if [ ! -f "$INDEX" ]; then
+    echo "No log index in $DIR" >&2
+    exit 1
+fi
+
+COUNT=$(( $(stat -c %s "$INDEX") / RECORD ))
+
+timeAt() {
+    od -An -v -t u4 -j $(( $1 * RECORD + 8 )) -N 8 "$INDEX" | awk '{ printf "%.0f", $1 + $2 * 4294967296 }'
+}
+
+# first entry logged at or after the given time
+seek() {
+    local lo=0 hi=$COUNT mid
+    while [ $lo -lt $hi ]; do
+        mid=$(( (lo + hi) / 2 ))
+        if [ "$(timeAt $mid)" -lt "$1" ]; then lo=$((mid + 1)); else hi=$mid; fi
+    done
+    echo $lo
+}
+
+FIRST=0
+LAST=$COUNT
+[ -n "$SINCE" ] && FIRST=$(seek "$SINCE")
+[ -n "$UNTIL" ] && LAST=$(seek "$UNTIL")
+[ "$FIRST" -lt "$LAST" ] || exit 0
+
+MOD_IDS=""
+if [ ${#MOD_NAMES[@]} -gt 0 ]; then
+    MOD_IDS=$(awk -F '\t' -v names="${MOD_NAMES[*]}" '
+        BEGIN { n = split(names, list, " "); for (i = 1; i <= n; i++) want[list[i]] = 1 }
+        ($2 in want) { printf "%s ", $1 }
+    ' "$MODS" 2>/dev/null)
+    [ -n "$MOD_IDS" ] || exit 0
+fi
+
+MATCHES=$(mktemp)
+trap 'rm -f "$MATCHES"' EXIT
+
+# entries are six little endian u32s: offset, time, severity and mod packed together, length
+dd if="$INDEX" bs=$RECORD skip="$FIRST" count=$((LAST - FIRST)) status=none \
+    | od -An -v -w$RECORD -t u4 \
+    | awk -v minSeverity=$MIN_SEVERITY -v mods="$MOD_IDS" '
+        BEGIN { n = split(mods, list, " "); for (i = 1; i <= n; i++) want[list[i]] = 1 }
+        {
+            if ($5 % 256 < minSeverity) next
+            if (n > 0 && !(int($5 / 65536) in want)) next
+            printf "%.0f %d\n", $1 + $2 * 4294967296, $6
+        }' > "$MATCHES"
+
+[ -s "$MATCHES" ] || exit 0
+START=$(head -n 1 "$MATCHES" | cut -d ' ' -f 1)
+
+# one pass over the log from the first match, a line can hold newlines of its own so lengths are tracked
+tail -c +$((START + 1)) "$LOG" | LC_ALL=C awk -v start="$START" '
+    NR == FNR { offsets[++count] = $1; lengths[count] = $2; next }
+    {
+        if (FNR == 1) { pos = start; next_match = 1; remaining = 0 }
+        size = length($0) + 1
+        while (next_match <= count && offsets[next_match] < pos) next_match++
+        if (remaining <= 0 && next_match <= count && pos == offsets[next_match]) {
+            remaining = lengths[next_match++]
+        }
+        if (remaining > 0) {
+            print
+            remaining -= size
+        }
+        else if (next_match > count) {
+            exit
+        }
+        pos += size
+    }
+' "$MATCHES" - | if [ "$PLAIN" = 1 ]; then sed 's/\x1b\[[0-9;]*m//g'; else cat; fi
 )script";
 
-    auto path = Config::get()->getUniquePath() / "openConsole.exe";
-    auto res = utils::file::writeString(path, script);
-    if (!res) return log::error("Failed to create openConsole script");
+    auto res = utils::file::writeString(Config::get()->getUniquePath() / "queryLog.sh", script);
+    if (!res) log::error("Failed to create queryLog script: {}", res.unwrapErr());
+}
+
+/*
+    If wine handed us the console's process handle the reactor waits on it and the counter is only read to
+    confirm the exit, since the handle can belong to a launcher that finishes straight away. Without one,
+    the counter is sampled once per expected beat against an adaptive threshold.
+*/
+void Console::setupHeartbeat(HANDLE process) {
+    if (m_hearbeatActive) {
+        if (process) CloseHandle(process);
+        return;
+    }
+    m_hearbeatActive = true;
+    m_consoleProcess = process;
+
+    m_heartbeatMonitor = std::make_unique<HeartbeatMonitor>(
+        std::chrono::milliseconds(1000 / std::max(Config::get()->getHeartbeatRate(), 1)),
+        std::chrono::milliseconds(Config::get()->getHeartbeatThreshold())
+    );
+
+    auto interval = std::chrono::duration_cast<std::chrono::milliseconds>(m_heartbeatMonitor->getExpectedInterval());
+    m_heartbeatTimer = Reactor::get()->addTimer(interval, [this] {
+        pollHeartbeat();
+    });
+
+    for (auto process : {"script", "terminal", "follow"}) {
+        Metrics::get()->observe("sobriety_helper_cpu_seconds", "CPU time used by the console's processes, sampled by its script every few seconds", [process] {
+            return readHelperCpu(process);
+        }, {{"process", process}});
+    }
 }
 
-void Console::setupHeartbeat() {
-    if (!m_hearbeatActive) {
-        setConsoleColors();
-
-        std::thread([] {
-            auto heartbeatPath = Config::get()->getUniquePath() / "console.heartbeat";
-            while (true) {
-                auto strRes = utils::file::readString(heartbeatPath);
-                if (!strRes) {
-                    continue;
-                } 
-
-                auto str = strRes.unwrap();
-                utils::string::trimIP(str);
-
-                auto millisRes = numFromString<long long>(str);
-
-                if (!millisRes) {
-                    continue;
-                }
-
-                auto millis = millisRes.unwrap();
-
-                auto now = std::chrono::system_clock::now();
-                auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    now.time_since_epoch()
-                ).count();
-
-                if (nowMs - millis > Config::get()->getHeartbeatThreshold()) {
-                    queueInMainThread([] {
-                        utils::game::exit(false);
-                    });
-                    break;
-                }
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
-            }
-        }).detach();
-        m_hearbeatActive = true;
+// the console script writes "<process> <milliseconds>" lines into heartbeat/console.cpu
+double Console::readHelperCpu(std::string_view process) {
+    auto res = utils::file::readString(Config::get()->getUniquePath() / "heartbeat" / "console.cpu");
+    if (!res) return 0.0;
+
+    for (auto& line : utils::string::split(res.unwrap(), "\n")) {
+        auto space = line.find(' ');
+        if (space == std::string::npos || std::string_view(line).substr(0, space) != process) continue;
+        return utils::numFromString<double>(line.substr(space + 1)).unwrapOr(0.0) / 1000.0;
     }
+    return 0.0;
 }
 
-std::string Console::buildLog(const Log& log) {
-    std::string ret;
+void Console::pollHeartbeat() {
+    TraceSpan span("heartbeat", "Console::pollHeartbeat");
+    auto now = HeartbeatMonitor::Clock::now();
+
+    if (!m_heartbeatCounter.isOpen()) {
+        if (!m_heartbeatCounter.open(Config::get()->getUniquePath() / "heartbeat" / "console.heartbeat")) return;
+
+        queueInMainThread([this] {
+            setConsoleColors();
+        });
 
-    if (Config::get()->shouldLogMillisconds()) {
-        ret = fmt::format("{:%H:%M:%S}.{:03}", log.time, log.milliseconds);
+        m_lastBeat = m_heartbeatCounter.read();
+        m_lastBeatAt = now;
+        m_heartbeatMonitor->beat(now);
+
+        if (m_consoleProcess) {
+            Reactor::get()->remove(m_heartbeatTimer);
+            m_heartbeatTimer = 0;
+            Reactor::get()->watchHandle(m_consoleProcess, [this] {
+                onConsoleProcessExit();
+            }, true);
+        }
+        return;
     }
-    else {
-        ret = fmt::format("{:%H:%M:%S}", log.time);
+
+    auto beat = m_heartbeatCounter.read();
+    if (beat != m_lastBeat) {
+        auto expected = std::chrono::duration_cast<HeartbeatMonitor::Clock::duration>(m_heartbeatMonitor->getExpectedInterval());
+        auto gap = now - m_lastBeatAt;
+        static auto& interval = Metrics::get()->histogram("sobriety_heartbeat_interval_seconds", "Time between heartbeats from the console");
+        static auto& jitter = Metrics::get()->histogram("sobriety_heartbeat_jitter_seconds", "How far the gap between heartbeats strays from the expected interval");
+        interval.record(gap);
+        jitter.record(gap > expected ? gap - expected : expected - gap);
+
+        m_lastBeat = beat;
+        m_lastBeatAt = now;
+        m_heartbeatMonitor->beat(now);
+        return;
     }
 
-    switch (log.severity.m_value) {
-        case Severity::Debug:
-            ret += " DEBUG";
-            break;
-        case Severity::Info:
-            ret += " INFO ";
-            break;
-        case Severity::Warning:
-            ret += " WARN ";
-            break;
-        case Severity::Error:
-            ret += " ERROR";
-            break;
-        default:
-            ret += " ?????";
-            break;
+    if (m_heartbeatMonitor->isDead(now)) {
+        static auto& detection = Metrics::get()->histogram("sobriety_exit_detection_seconds", "The console's last sign of life until the game notices it's gone");
+        detection.record(now - m_lastBeatAt);
+        Reactor::get()->remove(m_heartbeatTimer);
+        m_heartbeatTimer = 0;
+        queueInMainThread([] {
+            utils::game::exit(false);
+        });
     }
+}
 
-    if (log.threadName.empty())
-        ret += fmt::format(" [{}]: ", log.mod->getName());
-    else
-        ret += fmt::format(" [{}] [{}]: ", log.threadName, log.mod->getName());
+void Console::onConsoleProcessExit() {
+    Tracer::get()->instant("heartbeat", "console process exited");
+    CloseHandle(m_consoleProcess);
+    m_consoleProcess = nullptr;
 
-    ret += log.message;
+    m_lastBeat = m_heartbeatCounter.read();
+    m_lastBeatAt = HeartbeatMonitor::Clock::now();
+    m_heartbeatMonitor->beat(m_lastBeatAt);
 
-    return ret;
+    auto interval = std::chrono::duration_cast<std::chrono::milliseconds>(m_heartbeatMonitor->getExpectedInterval());
+    m_heartbeatTimer = Reactor::get()->addTimer(interval, [this] {
+        pollHeartbeat();
+    });
 }
 
-std::shared_ptr<FileAppender> Console::getLogAppender() {
-    return m_logAppender;
+std::shared_ptr<LogSink> Console::getLogSink() {
+    return m_logSink;
 }
\ No newline at end of file
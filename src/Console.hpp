@@ -2,35 +2,41 @@
 
 #include <Geode/loader/Mod.hpp>
 #include <memory>
-#include "FileAppender.hpp"
-
-struct Log {
-    geode::Mod* mod;
-    geode::Severity severity = geode::Severity::Info;
-    std::string message;
-    std::string threadName;
-    std::tm time;
-    long long milliseconds;
-    bool newLine;
-    int offset;
-};
+#include "HeartbeatMonitor.hpp"
+#include "LogSink.hpp"
+#include "MappedCounter.hpp"
+#include "Reactor.hpp"
 
 class Console {
 public:
     static Console* get();
 
     void setup();
+    void start();
     void setupHooks();
-    void setupScript();
+    std::filesystem::path setupScript();
+    void setupQueryScript();
     void setupLogFile();
-    void setupHeartbeat();
+    void setupHeartbeat(HANDLE process);
+    void pollHeartbeat();
+    void onConsoleProcessExit();
     void setConsoleColors();
-    std::string buildLog(const Log& log);
-    std::shared_ptr<FileAppender> getLogAppender();
+    std::shared_ptr<LogSink> getLogSink();
     LPTOP_LEVEL_EXCEPTION_FILTER getOriginalUEF();
+    const std::filesystem::path& getExitPath();
 
 private:
+    static double readHelperCpu(std::string_view process);
+
     bool m_hearbeatActive;
+    HANDLE m_consoleProcess = nullptr;
+    MappedCounter m_heartbeatCounter;
+    std::unique_ptr<HeartbeatMonitor> m_heartbeatMonitor;
+    uint64_t m_lastBeat = 0;
+    HeartbeatMonitor::Clock::time_point m_lastBeatAt;
+    Reactor::Id m_heartbeatTimer = 0;
     LPTOP_LEVEL_EXCEPTION_FILTER m_originalUEF;
-    std::shared_ptr<FileAppender> m_logAppender;
+    // built up front so the exception handler doesn't have to
+    std::filesystem::path m_exitPath;
+    std::shared_ptr<LogSink> m_logSink;
 };
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include <Geode/Geode.hpp>
+#include "ConsoleFilter.hpp"
+#include "Config.hpp"
+#include "Utils.hpp"
+
+using namespace geode::prelude;
+
+ConsoleFilter* ConsoleFilter::get() {
+    static ConsoleFilter instance;
+    return &instance;
+}
+
+ConsoleFilter::ConsoleFilter() {
+    auto table = std::make_unique<Table>();
+    table->defaultLevel = static_cast<uint8_t>(Severity::Info);
+    m_table.store(table.get(), std::memory_order_release);
+    m_current = std::move(table);
+}
+
+void ConsoleFilter::setup() {
+    rebuild();
+
+    static auto levelListener = listenForSettingChanges("console-log-level", [this](std::string) {
+        rebuild();
+    }, Loader::get()->getLoadedMod("geode.loader"));
+
+    static auto filtersListener = listenForSettingChanges("console-mod-filters", [this](std::string) {
+        rebuild();
+    });
+}
+
+void ConsoleFilter::rebuild() {
+    auto table = std::make_unique<Table>();
+    table->defaultLevel = static_cast<uint8_t>(Config::get()->getConsoleLogLevel().m_value);
+
+    std::vector<std::string> invalid;
+    for (auto& entry : utils::string::split(Config::get()->getConsoleModFilters(), ",")) {
+        utils::string::trimIP(entry);
+        if (entry.empty()) continue;
+
+        auto equals = entry.find('=');
+        if (equals == std::string::npos) {
+            invalid.push_back(entry);
+            continue;
+        }
+
+        auto id = utils::string::trim(entry.substr(0, equals));
+        auto level = utils::string::toLower(utils::string::trim(entry.substr(equals + 1)));
+
+        if (level == "mute" || level == "off") table->rules[id] = kMuted;
+        else if (level == "debug") table->rules[id] = static_cast<uint8_t>(Severity::Debug);
+        else if (level == "info") table->rules[id] = static_cast<uint8_t>(Severity::Info);
+        else if (level == "warning" || level == "warn") table->rules[id] = static_cast<uint8_t>(Severity::Warning);
+        else if (level == "error") table->rules[id] = static_cast<uint8_t>(Severity::Error);
+        else invalid.push_back(entry);
+    }
+
+    if (!table->rules.empty()) {
+        for (auto mod : Loader::get()->getAllMods()) {
+            table->levels[mod] = resolve(*table, mod);
+        }
+    }
+
+    publish(std::move(table));
+
+    // logged after the swap, logging goes through this filter
+    for (auto& entry : invalid) {
+        log::warn("Ignoring console filter \"{}\", expected <mod id>=<debug|info|warning|error|mute>", entry);
+    }
+}
+
+uint8_t ConsoleFilter::resolve(const Table& table, const Mod* mod) {
+    auto rule = table.rules.find(mod->getID());
+    return rule != table.rules.end() ? rule->second : table.defaultLevel;
+}
+
+void ConsoleFilter::publish(std::unique_ptr<Table> table) {
+    std::lock_guard lock(m_mutex);
+    auto now = std::chrono::steady_clock::now();
+
+    std::erase_if(m_retired, [&](const Retired& retired) {
+        return now - retired.at >= kGracePeriod;
+    });
+    if (m_current) m_retired.push_back({std::move(m_current), now});
+
+    m_table.store(table.get(), std::memory_order_release);
+    m_current = std::move(table);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Geode/loader/Mod.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+    Decides which lines reach the console. Readers load an immutable table and compare, settings changes
+    build a new table and swap it in. Readers never take a lock, so a replaced table is only freed once it
+    has been retired for kGracePeriod.
+
+    Rules come from a setting like "some.mod=debug, noisy.mod=mute". Each table resolves them up front for
+    every mod the loader knows about, including ones that haven't loaded yet, anything else is matched by
+    ID every time it logs.
+*/
+class ConsoleFilter {
+public:
+    static constexpr uint8_t kMuted = 0xff;
+    static constexpr auto kGracePeriod = std::chrono::seconds(10);
+
+    static ConsoleFilter* get();
+
+    void setup();
+    void rebuild();
+
+    bool isAccepted(geode::Mod* mod, geode::Severity severity) {
+        auto table = m_table.load(std::memory_order_acquire);
+        if (table->rules.empty()) return severity.m_value >= table->defaultLevel;
+
+        auto iter = table->levels.find(mod);
+        auto level = iter != table->levels.end() ? iter->second : resolve(*table, mod);
+        return level != kMuted && severity.m_value >= level;
+    }
+
+private:
+    struct Table {
+        uint8_t defaultLevel = 0;
+        std::unordered_map<std::string, uint8_t> rules;
+        std::unordered_map<const geode::Mod*, uint8_t> levels;
+    };
+
+    struct Retired {
+        std::unique_ptr<Table> table;
+        std::chrono::steady_clock::time_point at;
+    };
+
+    ConsoleFilter();
+
+    static uint8_t resolve(const Table& table, const geode::Mod* mod);
+    void publish(std::unique_ptr<Table> table);
+
+    std::atomic<const Table*> m_table;
+    std::mutex m_mutex;
+    std::unique_ptr<Table> m_current;
+    std::vector<Retired> m_retired;
+};
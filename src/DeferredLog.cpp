@@ -0,0 +1,202 @@
+#include <Geode/Geode.hpp>
+#include <fmt/args.h>
+#include <cctype>
+#include <unordered_set>
+#include "DeferredLog.hpp"
+#include "LogFormatter.hpp"
+
+using namespace geode::prelude;
+
+enum class ArgTag : uint8_t {
+    Int,
+    UInt,
+    LongLong,
+    ULongLong,
+    Bool,
+    Char,
+    Float,
+    Double,
+    LongDouble,
+    String,
+    Pointer
+};
+
+struct RecordHeader {
+    Mod* mod;
+    const std::string* threadName;
+    long long ms;
+    uint32_t threadId;
+    int severity;
+    uint32_t formatSize;
+    uint32_t argCount;
+};
+
+struct ThreadCaptureState {
+    std::string record;
+    long long nameSecond = -1;
+    const std::string* threadName = nullptr;
+};
+
+static thread_local ThreadCaptureState t_capture;
+
+// interned so a record can still point at the name after its thread has exited
+static const std::string* internThreadName(std::string name) {
+    static std::mutex mutex;
+    static std::unordered_set<std::string> names;
+
+    std::lock_guard lock(mutex);
+    return &*names.insert(std::move(name)).first;
+}
+
+template <class T>
+static void put(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+static T take(std::string_view& in) {
+    T value;
+    std::memcpy(&value, in.data(), sizeof(T));
+    in.remove_prefix(sizeof(T));
+    return value;
+}
+
+/*
+    Every type fmt stores by value gets an exact overload, anything else (custom type handles, 128 bit
+    integers) falls through to the template and makes the line format eagerly.
+*/
+struct CaptureVisitor {
+    std::string& out;
+
+    template <class T>
+    bool scalar(ArgTag tag, T value) {
+        put(out, tag);
+        put(out, value);
+        return true;
+    }
+
+    bool string(std::string_view value) {
+        put(out, ArgTag::String);
+        put(out, static_cast<uint32_t>(value.size()));
+        out.append(value.data(), value.size());
+        return true;
+    }
+
+    bool operator()(int value) { return scalar(ArgTag::Int, value); }
+    bool operator()(unsigned value) { return scalar(ArgTag::UInt, value); }
+    bool operator()(long long value) { return scalar(ArgTag::LongLong, value); }
+    bool operator()(unsigned long long value) { return scalar(ArgTag::ULongLong, value); }
+    bool operator()(bool value) { return scalar(ArgTag::Bool, value); }
+    bool operator()(char value) { return scalar(ArgTag::Char, value); }
+    bool operator()(float value) { return scalar(ArgTag::Float, value); }
+    bool operator()(double value) { return scalar(ArgTag::Double, value); }
+    bool operator()(long double value) { return scalar(ArgTag::LongDouble, value); }
+    bool operator()(const void* value) { return scalar(ArgTag::Pointer, value); }
+    bool operator()(const char* value) { return value && string(value); }
+    bool operator()(fmt::string_view value) { return string(std::string_view(value.data(), value.size())); }
+
+    template <class T>
+    bool operator()(T&&) { return false; }
+};
+
+/*
+    Only argument values are packed, their names are lost, so a field that refers to an argument by name
+    (including a nested width or precision) can't be rendered later. "{{" is an escaped brace, not a field.
+*/
+static bool hasNamedField(fmt::string_view format) {
+    auto data = format.data();
+    for (size_t i = 0; i + 1 < format.size(); i++) {
+        if (data[i] != '{') continue;
+        if (data[i + 1] == '{') {
+            i++;
+            continue;
+        }
+        auto c = static_cast<unsigned char>(data[i + 1]);
+        if (c == '_' || std::isalpha(c)) return true;
+    }
+    return false;
+}
+
+std::string_view DeferredLog::capture(Severity severity, Mod* mod, fmt::string_view format, fmt::format_args args) {
+    if (hasNamedField(format)) return {};
+
+    auto& state = t_capture;
+    auto& out = state.record;
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+
+    if (ms / 1000 != state.nameSecond) {
+        state.threadName = internThreadName(thread::getName());
+        state.nameSecond = ms / 1000;
+    }
+
+    out.resize(sizeof(RecordHeader));
+    out.append(format.data(), format.size());
+
+    uint32_t argCount = 0;
+    for (int i = 0;; i++) {
+        auto arg = args.get(i);
+        if (!arg) break;
+        if (!fmt::visit_format_arg(CaptureVisitor{out}, arg)) return {};
+        argCount++;
+    }
+
+    RecordHeader header{
+        mod, state.threadName, ms, static_cast<uint32_t>(GetCurrentThreadId()), severity.m_value,
+        static_cast<uint32_t>(format.size()), argCount
+    };
+    std::memcpy(out.data(), &header, sizeof(header));
+
+    return out;
+}
+
+DeferredLog::Rendered DeferredLog::render(fmt::memory_buffer& buffer, std::string_view record) {
+    thread_local fmt::dynamic_format_arg_store<fmt::format_context> store;
+    store.clear();
+
+    auto header = take<RecordHeader>(record);
+    auto format = record.substr(0, header.formatSize);
+    record.remove_prefix(header.formatSize);
+
+    for (uint32_t i = 0; i < header.argCount; i++) {
+        switch (take<ArgTag>(record)) {
+            case ArgTag::Int: store.push_back(take<int>(record)); break;
+            case ArgTag::UInt: store.push_back(take<unsigned>(record)); break;
+            case ArgTag::LongLong: store.push_back(take<long long>(record)); break;
+            case ArgTag::ULongLong: store.push_back(take<unsigned long long>(record)); break;
+            case ArgTag::Bool: store.push_back(take<bool>(record)); break;
+            case ArgTag::Char: store.push_back(take<char>(record)); break;
+            case ArgTag::Float: store.push_back(take<float>(record)); break;
+            case ArgTag::Double: store.push_back(take<double>(record)); break;
+            case ArgTag::LongDouble: store.push_back(take<long double>(record)); break;
+            case ArgTag::Pointer: store.push_back(take<const void*>(record)); break;
+            case ArgTag::String: {
+                auto size = take<uint32_t>(record);
+                store.push_back(fmt::string_view(record.data(), size));
+                record.remove_prefix(size);
+                break;
+            }
+        }
+    }
+
+    auto start = buffer.size();
+    auto messageStart = start;
+    try {
+        messageStart = LogFormatter::formatTo(
+            buffer, header.severity, header.mod, *header.threadName, header.ms,
+            fmt::string_view(format.data(), format.size()), store
+        );
+    }
+    catch (const fmt::format_error& e) {
+        // a bad runtime format string only shows up here
+        buffer.resize(start);
+        fmt::format_to(fmt::appender(buffer), "Failed to render log line \"{}\": {}\n", format, e.what());
+    }
+
+    return {
+        header.severity, header.mod, header.ms, header.threadId,
+        std::string_view(buffer.data() + messageStart, buffer.size() - messageStart - 1)
+    };
+}
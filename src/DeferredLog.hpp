@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Geode/loader/Mod.hpp>
+#include <string>
+#include <string_view>
+
+/*
+    Lets the logging thread skip formatting entirely. capture packs the format text, the arguments and
+    everything the line prefix needs into a flat record, and the sink's writer thread renders it later.
+
+    Strings are copied since there's no telling how long the caller keeps them around, that includes the
+    format text itself as fmt::runtime strings are often temporaries. Custom types are formatted through
+    a handle that points into the caller's stack, so lines with any of those are formatted eagerly instead,
+    as are lines that refer to an argument by name.
+*/
+class DeferredLog {
+public:
+    // what render found in the record, message points into the buffer
+    struct Rendered {
+        geode::Severity severity;
+        geode::Mod* mod;
+        long long ms;
+        uint32_t threadId;
+        std::string_view message;
+    };
+
+    // returns an empty view when the line has to be formatted eagerly, otherwise valid until the next call on this thread
+    static std::string_view capture(geode::Severity severity, geode::Mod* mod, fmt::string_view format, fmt::format_args args);
+    static Rendered render(fmt::memory_buffer& buffer, std::string_view record);
+};
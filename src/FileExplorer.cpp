@@ -3,8 +3,12 @@
 #include <Geode/modify/CCKeyboardDispatcher.hpp>
 #include <Geode/modify/CCMouseDispatcher.hpp>
 #include "FileExplorer.hpp"
+#include "Metrics.hpp"
 #include "Config.hpp"
 #include "FileWatcher.hpp"
+#include "PathTranslator.hpp"
+#include "Scheduler.hpp"
+#include "Tracer.hpp"
 #include "Utils.hpp"
 
 using namespace geode::prelude;
@@ -17,11 +21,12 @@ FileExplorer* FileExplorer::get() {
 void FileExplorer::setup() {
     sobriety::utils::createTempDir();
 
-    auto watcher = FileWatcher::getForDirectory(Config::get()->getUniquePath());
-    watcher->watch("selectedFile.txt", [this] {
-        notifySelectedFileChange();
-    });
-    setupScript();
+    if (!Config::get()->usePickerPipe()) {
+        auto watcher = FileWatcher::getForDirectory(Config::get()->getUniquePath());
+        watcher->watch("selectedFile.txt", [this] {
+            notifySelectedFileChange();
+        });
+    }
     setupHooks();
 }
 
@@ -88,18 +93,28 @@ Task<Result<std::vector<std::filesystem::path>>> file_pickMany_h(const utils::fi
     It works and grabs the right *visible* default. Running GD through steam does block access to some files,
     meaning that it likely wont always grab the right default and falls back to GTK.
 */
-void FileExplorer::setupScript() {
+std::filesystem::path FileExplorer::setupScript() {
     static std::string script = 
 R"script(#!/bin/bash
 
 export GTK_USE_PORTAL=1
 
+# "-" writes the result to stdout for the game to read from a pipe, anything else is the directory to
+# write selectedFile.txt into
 UNIQUE_PATH="$1"
 shift
 
 TMP="$UNIQUE_PATH/selectedFile.txt"
 
-> "$TMP"
+emit() {
+    if [ "$UNIQUE_PATH" = "-" ]; then
+        cat
+    else
+        cat > "$TMP"
+    fi
+}
+
+[ "$UNIQUE_PATH" != "-" ] && > "$TMP"
 
 START_PATH="$1"
 shift
@@ -136,6 +151,13 @@ if ! command -v "$PICKER" >/dev/null 2>&1; then
     fi
 fi
 
+# SOBRIETY_PICKER runs another binary as the picker it's named after, for stubs and custom builds
+PICKER_BIN="$PICKER"
+if [ -n "$SOBRIETY_PICKER" ]; then
+    PICKER_BIN="$SOBRIETY_PICKER"
+    PICKER="$(basename "$SOBRIETY_PICKER")"
+fi
+
 DEFAULT_FILE=""
 if [ "$MODE" = "save" ] && [ "${#FILTERS[@]}" -gt 0 ]; then
     IFS='|' read -r desc exts <<< "${FILTERS[0]}"
@@ -150,13 +172,13 @@ launch_picker() {
 
     case "$PICKER" in
         zenity)
-            CMD=(zenity --title="$TITLE" --filename="$START_PATH/$DEFAULT_FILE")
+            CMD=("$PICKER_BIN" --title="$TITLE" --filename="$START_PATH/$DEFAULT_FILE")
             case "$MODE" in
                 single) CMD+=(--file-selection) ;;
                 multi) CMD+=(--file-selection --multiple --separator=":") ;;
                 dir) CMD+=(--file-selection --directory) ;;
                 save) CMD+=(--file-selection --save) ;;
-                browse) xdg-open "$START_PATH"; FILE=""; STATUS=0; return ;;
+                browse) xdg-open "$START_PATH" >/dev/null 2>&1; FILE=""; STATUS=0; return ;;
                 *) CMD+=(--file-selection) ;;
             esac
             for f in "${FILTERS[@]}"; do
@@ -174,23 +196,23 @@ launch_picker() {
                 FILTER_STRING+="$exts | $desc"
             done
             case "$MODE" in
-                single) FILE=$(kdialog --title "$TITLE" --getopenfilename "$START_PATH" "$FILTER_STRING") ;;
-                multi) FILE=$(kdialog --title "$TITLE" --getopenfilenames "$START_PATH" "$FILTER_STRING") ;;
-                dir) FILE=$(kdialog --title "$TITLE" --getexistingdirectory "$START_PATH") ;;
-                save) FILE=$(kdialog --title "$TITLE" --getsavefilename "$START_PATH/$DEFAULT_FILE" "$FILTER_STRING") ;;
-                browse) xdg-open "$START_PATH"; FILE=""; STATUS=0; return ;;
-                *) FILE=$(kdialog --title "$TITLE" --getopenfilename "$START_PATH" "$FILTER_STRING") ;;
+                single) FILE=$("$PICKER_BIN" --title "$TITLE" --getopenfilename "$START_PATH" "$FILTER_STRING") ;;
+                multi) FILE=$("$PICKER_BIN" --title "$TITLE" --getopenfilenames "$START_PATH" "$FILTER_STRING") ;;
+                dir) FILE=$("$PICKER_BIN" --title "$TITLE" --getexistingdirectory "$START_PATH") ;;
+                save) FILE=$("$PICKER_BIN" --title "$TITLE" --getsavefilename "$START_PATH/$DEFAULT_FILE" "$FILTER_STRING") ;;
+                browse) xdg-open "$START_PATH" >/dev/null 2>&1; FILE=""; STATUS=0; return ;;
+                *) FILE=$("$PICKER_BIN" --title "$TITLE" --getopenfilename "$START_PATH" "$FILTER_STRING") ;;
             esac
             STATUS=$?
             ;;
         yad)
-            CMD=(yad --title="$TITLE" --filename="$START_PATH/$DEFAULT_FILE")
+            CMD=("$PICKER_BIN" --title="$TITLE" --filename="$START_PATH/$DEFAULT_FILE")
             case "$MODE" in
                 single) CMD+=(--file-selection) ;;
                 multi) CMD+=(--file-selection --multiple --separator=":") ;;
                 dir) CMD+=(--file-selection --directory) ;;
                 save) CMD+=(--file-selection --save) ;;
-                browse) xdg-open "$START_PATH"; FILE=""; STATUS=0; return ;;
+                browse) xdg-open "$START_PATH" >/dev/null 2>&1; FILE=""; STATUS=0; return ;;
                 *) CMD+=(--file-selection) ;;
             esac
             for f in "${FILTERS[@]}"; do
@@ -201,7 +223,7 @@ launch_picker() {
             STATUS=$?
             ;;
         xdg-open)
-            xdg-open "$START_PATH"
+            xdg-open "$START_PATH" >/dev/null 2>&1
             FILE=""
             STATUS=0
             ;;
@@ -211,22 +233,22 @@ launch_picker() {
         case "$PICKER" in
             zenity|yad)
                 if [ "$MODE" = "multi" ]; then
-                    echo "$FILE" | tr ':' '\n' > "$TMP"
+                    echo "$FILE" | tr ':' '\n' | emit
                 else
-                    echo "$FILE" > "$TMP"
+                    echo "$FILE" | emit
                 fi
                 ;;
             kdialog)
                 if [ "$MODE" = "multi" ]; then
-                    echo "$FILE" | sed 's/"//g' | tr ' ' '\n' > "$TMP"
+                    echo "$FILE" | sed 's/"//g' | tr ' ' '\n' | emit
                 else
-                    echo "$FILE" > "$TMP"
+                    echo "$FILE" | emit
                 fi
                 ;;
             xdg-open) ;;
         esac
     else
-        [ "$STATUS" -ne 0 ] && echo "-1" > "$TMP"
+        [ "$STATUS" -ne 0 ] && echo "-1" | emit
     fi
 }
 
@@ -241,9 +263,18 @@ launch_picker &
         and properly bridge between some linux based script and wine.
     */
 
-    auto path = Config::get()->getUniquePath() / "openFile.exe";
-    auto res = utils::file::writeString(path, script);
-    if (!res) return log::error("Failed to create openFile script");
+    auto res = sobriety::utils::emitScript("openFile", script);
+    if (!res) {
+        log::error("Failed to create openFile script: {}", res.unwrapErr());
+        return {};
+    }
+    return res.unwrap();
+}
+
+// the script isn't needed until the first pick, so it stays off the startup path
+const std::filesystem::path& FileExplorer::getScriptPath() {
+    static std::filesystem::path path = setupScript();
+    return path;
 }
 
 void FileExplorer::setupHooks() {
@@ -265,12 +296,12 @@ void FileExplorer::setupHooks() {
 }
 
 void FileExplorer::openFile(const std::string& startPath, PickMode pickMode, const std::vector<std::string>& filters) {
-    auto path = Config::get()->getUniquePath() / "openFile.exe";
-    
-    std::string command = utils::string::pathToString(path);
+    TraceSpan span("picker", "FileExplorer::openFile");
+    std::string command;
+    bool pipe = Config::get()->usePickerPipe() && pickMode != PickMode::BrowseFiles;
 
     command += " \"";
-    command += utils::string::pathToString(Config::get()->getUniquePath());
+    command += pipe ? "-" : utils::string::pathToString(Config::get()->getUniquePath());
     command += "\"";
 
     command += " \"";
@@ -333,7 +364,39 @@ void FileExplorer::openFile(const std::string& startPath, PickMode pickMode, con
         command += "\"";
     }
 
-    sobriety::utils::runCommand(command);
+    // the round trip ends in onSelection, browsing never comes back with one
+    if (pickMode != PickMode::BrowseFiles) {
+        Tracer::get()->asyncBegin("picker", "pick", ++m_pickId);
+        m_pickStart = std::chrono::steady_clock::now();
+    }
+
+    if (!pipe) {
+        Scheduler::get()->post([this, command = std::move(command)] {
+            sobriety::utils::runCommand(utils::string::pathToString(getScriptPath()) + command);
+        });
+        return;
+    }
+
+    /*
+        The picker writes its answer to our pipe and the pipe closing is the completion, so the result arrives
+        exactly once with no temp file or watcher involved. A picker that closes without answering counts as
+        cancelled, otherwise the game would stay locked.
+
+        Reading it blocks for as long as the dialog is open, so it gets a thread of its own instead of holding
+        one of the scheduler's workers. The pipe isn't something the reactor can wait on.
+    */
+    std::thread([this, command = std::move(command)] {
+        thread::setName("Sobriety File Picker");
+
+        auto selection = PickSelection{true};
+        auto outputRes = sobriety::utils::runCommandForOutput(utils::string::pathToString(getScriptPath()) + command);
+        if (!outputRes) log::error("Failed to run file picker: {}", outputRes.unwrapErr());
+        else selection = parseSelection(outputRes.unwrap()).value_or(PickSelection{true});
+
+        queueInMainThread([this, selection = std::move(selection)]() mutable {
+            onSelection(std::move(selection));
+        });
+    }).detach();
 }
 
 bool FileExplorer::isPickerActive() {
@@ -352,53 +415,41 @@ std::shared_ptr<PickerState> FileExplorer::getState() {
     return m_state;
 }
 
-std::vector<std::string> FileExplorer::generateExtensionStrings(std::vector<utils::file::FilePickOptions::Filter> filters) {
-    std::vector<std::string> strings;
-
-    filters.push_back({"All Files", {"*.*"}});
-
-    for (const auto& filter : filters) {
-        std::string extStr = utils::string::trim(filter.description);
-        extStr += "|";
-        for (const auto& extension : filter.files) {
-            extStr += utils::string::trim(extension);
-            extStr += " ";
-        }
-        strings.push_back(utils::string::trim(extStr));
-    }
-    return strings;
-}
-
+/*
+    Reading and splitting the selection happens on a worker, only handing the result to the task's
+    callbacks is left for the main thread.
+*/
 void FileExplorer::notifySelectedFileChange() {
+    TraceSpan span("picker", "FileExplorer::notifySelectedFileChange");
     auto path = Config::get()->getUniquePath() / "selectedFile.txt";
 
-    auto strRes = utils::file::readString(path);
-    if (!strRes) return;
-
-    std::string str = strRes.unwrap();
-    utils::string::trimIP(str);
-
-    if (str.empty()) return;
+    Scheduler::get()->postThenMain([path] {
+        TraceSpan span("picker", "read selectedFile.txt");
+        auto strRes = utils::file::readString(path);
+        if (!strRes) return std::optional<PickSelection>();
+        return parseSelection(strRes.unwrap());
+    }, [this](std::optional<PickSelection> selection) {
+        if (selection) onSelection(std::move(*selection));
+    });
+}
 
+void FileExplorer::onSelection(PickSelection&& selection) {
     if (!m_state) return;
+    Tracer::get()->asyncEnd("picker", "pick", m_pickId);
+    if (m_pickStart != std::chrono::steady_clock::time_point{}) {
+        static auto& roundTrip = Metrics::get()->histogram("sobriety_picker_round_trip_seconds", "openFile called until the selection reaches the callback");
+        roundTrip.record(std::chrono::steady_clock::now() - m_pickStart);
+        m_pickStart = {};
+    }
 
-    if (str == "-1") {
+    if (selection.cancelled) {
         if (m_state->cancelledCallback) m_state->cancelledCallback();
     }
     else if (m_state->fileCallback) {
-        m_state->fileCallback(Ok(std::filesystem::path(str)));
+        m_state->fileCallback(Ok(selection.paths.empty() ? std::filesystem::path(selection.text) : std::move(selection.paths.front())));
     }
     else if (m_state->filesCallback) {
-        auto parts = utils::string::split(str, "\n");
-
-        std::vector<std::filesystem::path> paths;
-        paths.reserve(parts.size());
-
-        for (auto& p : parts) {
-            if (!p.empty()) paths.emplace_back(p);
-        }
-
-        m_state->filesCallback(Ok(std::move(paths)));
+        m_state->filesCallback(Ok(std::move(selection.paths)));
     }
 
     m_pickerActive = false;
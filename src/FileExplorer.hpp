@@ -2,6 +2,11 @@
 
 #include <Geode/Result.hpp>
 #include <Geode/utils/file.hpp>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
 enum class PickMode {
@@ -12,6 +17,12 @@ enum class PickMode {
     BrowseFiles
 };
 
+struct PickSelection {
+    bool cancelled = false;
+    std::string text;
+    std::vector<std::filesystem::path> paths;
+};
+
 struct PickerState {
     std::function<void(geode::Result<std::filesystem::path>)> fileCallback;
     std::function<void(geode::Result<std::vector<std::filesystem::path>>)> filesCallback;
@@ -24,17 +35,22 @@ public:
 
     void setup();
     void setupHooks();
-    void setupScript();
+    std::filesystem::path setupScript();
+    const std::filesystem::path& getScriptPath();
     void openFile(const std::string& startPath, PickMode pickMode, const std::vector<std::string>& filters);
     bool isPickerActive();
     void setPickerActive(bool active);
     void setState(std::shared_ptr<PickerState> state);
     void notifySelectedFileChange();
+    void onSelection(PickSelection&& selection);
+    static std::optional<PickSelection> parseSelection(std::string str);
 
     std::shared_ptr<PickerState> getState();
-    std::vector<std::string> generateExtensionStrings(std::vector<geode::utils::file::FilePickOptions::Filter> filters);
+    static std::vector<std::string> generateExtensionStrings(std::vector<geode::utils::file::FilePickOptions::Filter> filters);
 
 private:
     std::shared_ptr<PickerState> m_state;
     bool m_pickerActive = false;
+    uint64_t m_pickId = 0;
+    std::chrono::steady_clock::time_point m_pickStart;
 };
@@ -1,6 +1,7 @@
 #include <Geode/Geode.hpp>
 #include "FileWatcher.hpp"
-#include "Scheduler.hpp"
+#include "Metrics.hpp"
+#include "Tracer.hpp"
 
 using namespace geode::prelude;
 
@@ -12,6 +13,7 @@ FileWatcher* FileWatcher::getForDirectory(const std::filesystem::path& directory
     if (iter == s_watchers.end()) {
         auto watcher = std::make_shared<FileWatcher>(directory);
         s_watchers[directory] = watcher;
+        watcher->start();
         return watcher.get();
     }
     else {
@@ -29,9 +31,13 @@ void FileWatcher::watch(const std::string& name, std::function<void()>&& method)
     m_filesToWatch[name] = std::move(method);
 }
 
-FileWatcher::FileWatcher(const std::filesystem::path& directory) {
+void FileWatcher::unwatch(const std::string& name) {
+    m_filesToWatch.erase(name);
+}
+
+FileWatcher::FileWatcher(const std::filesystem::path& directory, size_t bufferSize) {
     m_directory = directory;
-    m_id = fmt::format("{}-schedule", utils::string::pathToString(directory));
+    m_buffer.resize(std::max<size_t>(bufferSize, 1024) / sizeof(DWORD));
 
     m_handle = CreateFileW(
         directory.c_str(),
@@ -48,51 +54,151 @@ FileWatcher::FileWatcher(const std::filesystem::path& directory) {
         return;
     }
 
-    std::thread([this] {
-        while (true) {
-            if (!ReadDirectoryChangesW(
-                m_handle,
-                m_buffer,
-                sizeof(m_buffer),
-                TRUE,
-                FILE_NOTIFY_CHANGE_FILE_NAME |
-                FILE_NOTIFY_CHANGE_DIR_NAME |
-                FILE_NOTIFY_CHANGE_ATTRIBUTES |
-                FILE_NOTIFY_CHANGE_SIZE |
-                FILE_NOTIFY_CHANGE_LAST_WRITE |
-                FILE_NOTIFY_CHANGE_CREATION,
-                &m_bytesReturned,
-                nullptr,
-                nullptr
-            )) {
-                log::error("Failed to read directory changes: {}", GetLastError());
-                return;
-            }
-
-            auto change = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(m_buffer);
-            do {
-                std::wstring wname(change->FileName, change->FileNameLength / sizeof(WCHAR));
-                std::string name = utils::string::wideToUtf8(wname);
-
-                queueInMainThread([name, this] {
-                    for (const auto& [k, v] : m_filesToWatch) {
-                        if (name == k) {
-                            if (v) v();
-                        }
-                    }
-                });
-                
-                change = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(
-                    reinterpret_cast<char*>(change) + change->NextEntryOffset
-                );
-            } while (change->NextEntryOffset != 0);
-        }
-    }).detach();
+    m_overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
 }
 
 FileWatcher::~FileWatcher() {
+    if (m_reactorId) Reactor::get()->remove(m_reactorId);
+
     if (m_handle != INVALID_HANDLE_VALUE) {
+        DWORD bytes = 0;
+        if (CancelIoEx(m_handle, &m_overlapped)) {
+            GetOverlappedResult(m_handle, &m_overlapped, &bytes, TRUE);
+        }
         CloseHandle(m_handle);
     }
-    Scheduler::get()->unschedule(m_id);
-}
\ No newline at end of file
+    if (m_overlapped.hEvent) CloseHandle(m_overlapped.hEvent);
+}
+
+/*
+    Reads are issued and completed on the reactor thread, which waits on the overlapped event alongside
+    everything else instead of this watcher parking a thread of its own.
+*/
+void FileWatcher::start() {
+    if (m_handle == INVALID_HANDLE_VALUE || m_reactorId) return;
+    if (!read()) return;
+
+    m_reactorId = Reactor::get()->watchHandle(m_overlapped.hEvent, [this] {
+        onCompleted();
+    });
+}
+
+bool FileWatcher::read() {
+    ResetEvent(m_overlapped.hEvent);
+
+    if (!ReadDirectoryChangesW(
+        m_handle,
+        m_buffer.data(),
+        static_cast<DWORD>(m_buffer.size() * sizeof(DWORD)),
+        FALSE,
+        FILE_NOTIFY_CHANGE_FILE_NAME |
+        FILE_NOTIFY_CHANGE_DIR_NAME |
+        FILE_NOTIFY_CHANGE_ATTRIBUTES |
+        FILE_NOTIFY_CHANGE_SIZE |
+        FILE_NOTIFY_CHANGE_LAST_WRITE |
+        FILE_NOTIFY_CHANGE_CREATION,
+        nullptr,
+        &m_overlapped,
+        nullptr
+    )) {
+        log::error("Failed to read directory changes: {}", GetLastError());
+        return false;
+    }
+    return true;
+}
+
+void FileWatcher::onCompleted() {
+    DWORD bytes = 0;
+    if (!GetOverlappedResult(m_handle, &m_overlapped, &bytes, FALSE)) {
+        if (GetLastError() != ERROR_NOTIFY_ENUM_DIR) {
+            log::error("Failed to read directory changes: {}", GetLastError());
+            Reactor::get()->remove(m_reactorId);
+            m_reactorId = 0;
+            return;
+        }
+        bytes = 0;
+    }
+
+    collect(bytes);
+
+    if (!read()) {
+        Reactor::get()->remove(m_reactorId);
+        m_reactorId = 0;
+    }
+}
+
+/*
+    Zero bytes means the kernel's queue overflowed and the individual changes are gone,
+    so every watched file is treated as changed.
+*/
+void FileWatcher::collect(DWORD bytes) {
+    static auto& received = Metrics::get()->counter("sobriety_watcher_events_received_total", "Change notifications read from watched directories");
+    static auto& overflows = Metrics::get()->counter("sobriety_watcher_overflows_total", "Times a watched directory's change queue overflowed");
+    std::lock_guard lock(m_mutex);
+
+    if (bytes == 0) {
+        overflows.add();
+        m_overflowed = true;
+    }
+    else {
+        auto data = reinterpret_cast<char*>(m_buffer.data());
+        while (true) {
+            auto change = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(data);
+            std::wstring wname(change->FileName, change->FileNameLength / sizeof(WCHAR));
+            m_changed.insert(utils::string::wideToUtf8(wname));
+            received.add();
+
+            if (change->NextEntryOffset == 0) break;
+            data += change->NextEntryOffset;
+        }
+    }
+
+    queueDispatch();
+}
+
+/*
+    Changes pile up in m_changed until the main thread gets around to them, so a burst only ever costs
+    one queued callback per frame and each file fires once no matter how many events it produced.
+*/
+void FileWatcher::queueDispatch() {
+    if (m_dispatchQueued) return;
+    m_dispatchQueued = true;
+
+    queueInMainThread([weak = weak_from_this()] {
+        if (auto self = weak.lock()) self->dispatch();
+    });
+}
+
+void FileWatcher::dispatch() {
+    TraceSpan span("watcher", "FileWatcher::dispatch");
+    static auto& dispatched = Metrics::get()->counter("sobriety_watcher_events_dispatched_total", "Watched file callbacks run, after coalescing");
+
+    std::unordered_set<std::string> changed;
+    bool overflowed;
+    {
+        std::lock_guard lock(m_mutex);
+        changed.swap(m_changed);
+        overflowed = m_overflowed;
+        m_overflowed = false;
+        m_dispatchQueued = false;
+    }
+
+    // callbacks can watch and unwatch files, so the map is looked up again for every one and each is copied
+    // before it runs, in case it unwatches itself
+    std::vector<std::string> names;
+    if (overflowed) {
+        for (const auto& [name, method] : m_filesToWatch) names.push_back(name);
+    }
+    else {
+        names.assign(changed.begin(), changed.end());
+    }
+
+    for (const auto& name : names) {
+        auto iter = m_filesToWatch.find(name);
+        if (iter == m_filesToWatch.end() || !iter->second) continue;
+
+        auto method = iter->second;
+        dispatched.add();
+        method();
+    }
+}
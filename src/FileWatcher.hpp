@@ -1,25 +1,48 @@
 #pragma once
 
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "Reactor.hpp"
 
-class FileWatcher {
+class FileWatcher : public std::enable_shared_from_this<FileWatcher> {
 public:
-    FileWatcher(const std::filesystem::path& directory);
+    static constexpr size_t kDefaultBufferSize = 64 * 1024;
+
+    FileWatcher(const std::filesystem::path& directory, size_t bufferSize = kDefaultBufferSize);
     ~FileWatcher();
 
     static FileWatcher* getForDirectory(const std::filesystem::path& directory);
     static void removeDirectory(const std::filesystem::path& directory);
 
     void watch(const std::string& name, std::function<void()>&& method);
+    void unwatch(const std::string& name);
 
 private:
-    std::string m_id;
+    void start();
+    bool read();
+    void onCompleted();
+    void collect(DWORD bytes);
+    void queueDispatch();
+    void dispatch();
+
     std::filesystem::path m_directory;
     std::unordered_map<std::string, std::function<void()>> m_filesToWatch;
 
-    HANDLE m_handle;
-    char m_buffer[1024];
-    DWORD m_bytesReturned;
+    HANDLE m_handle = INVALID_HANDLE_VALUE;
+    OVERLAPPED m_overlapped{};
+    std::vector<DWORD> m_buffer;
+    Reactor::Id m_reactorId = 0;
+
+    std::mutex m_mutex;
+    std::unordered_set<std::string> m_changed;
+    bool m_overflowed = false;
+    bool m_dispatchQueued = false;
 
     static std::unordered_map<std::filesystem::path, std::shared_ptr<FileWatcher>> s_watchers;
-};
\ No newline at end of file
+};
@@ -0,0 +1,177 @@
+#include <Geode/Geode.hpp>
+#include <unordered_map>
+#include "FlightRecorder.hpp"
+#include "Utils.hpp"
+
+using namespace geode::prelude;
+
+static constexpr size_t kMappingSize = FlightRecorder::kSlotSize * (FlightRecorder::kSlotCount + 1) + sizeof(FlightRecorder::Trailer);
+
+static int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+FlightRecorder* FlightRecorder::get() {
+    static FlightRecorder instance;
+    return &instance;
+}
+
+void FlightRecorder::setup(const std::filesystem::path& path) {
+    m_file = CreateFileW(
+        path.c_str(),
+        GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_DELETE,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (m_file == INVALID_HANDLE_VALUE) return log::error("Failed to create flight recorder file: {}", GetLastError());
+
+    m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(kMappingSize), nullptr);
+    if (!m_mapping) return log::error("Failed to map flight recorder file: {}", GetLastError());
+
+    auto view = static_cast<char*>(MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, kMappingSize));
+    if (!view) return log::error("Failed to map flight recorder view: {}", GetLastError());
+
+    // the mapping starts out zeroed, so every slot reads as empty
+    auto header = reinterpret_cast<Header*>(view);
+    header->magic = kMagic;
+    header->slotSize = kSlotSize;
+    header->slotCount = kSlotCount;
+    header->next.store(0, std::memory_order_relaxed);
+
+    m_slots = reinterpret_cast<Slot*>(view + kSlotSize);
+    m_trailer = reinterpret_cast<Trailer*>(view + kSlotSize * (kSlotCount + 1));
+    m_header = header;
+}
+
+/*
+    Slots are handed out round robin. A writer that's still busy when the ring wraps all the way around to it
+    would share its slot with a new one, that needs thousands of lines in between so it's not guarded against.
+*/
+FlightRecorder::Slot* FlightRecorder::claim(uint8_t kind, uint64_t& sequence) {
+    auto index = m_header->next.fetch_add(1, std::memory_order_relaxed);
+    auto slot = &m_slots[index % kSlotCount];
+    sequence = index + 1;
+
+    slot->sequence.store(0, std::memory_order_relaxed);
+    slot->ms = nowMs();
+    slot->threadId = GetCurrentThreadId();
+    slot->kind = kind;
+    return slot;
+}
+
+const std::string& FlightRecorder::getModId(Mod* mod) {
+    thread_local std::unordered_map<Mod*, std::string> modIds;
+    auto iter = modIds.find(mod);
+    if (iter == modIds.end()) {
+        iter = modIds.emplace(mod, mod->getID()).first;
+    }
+    return iter->second;
+}
+
+void FlightRecorder::record(Severity severity, Mod* mod, fmt::string_view format, fmt::format_args args) {
+    if (!m_header) return;
+
+    uint64_t sequence;
+    auto slot = claim(static_cast<uint8_t>(severity.m_value), sequence);
+    auto end = slot->text + sizeof(slot->text);
+
+    auto out = fmt::format_to_n(slot->text, sizeof(slot->text), "[{}]: ", getModId(mod)).out;
+    if (out < end) {
+        out = fmt::vformat_to_n(out, end - out, format, args).out;
+    }
+    slot->length = static_cast<uint16_t>(std::min(out, end) - slot->text);
+
+    slot->sequence.store(sequence, std::memory_order_release);
+}
+
+void FlightRecorder::record(Severity severity, Mod* mod, std::string_view message, int64_t ms, uint32_t threadId) {
+    if (!m_header) return;
+
+    uint64_t sequence;
+    auto slot = claim(static_cast<uint8_t>(severity.m_value), sequence);
+    if (ms != 0) slot->ms = ms;
+    if (threadId != 0) slot->threadId = threadId;
+
+    auto out = fmt::format_to_n(slot->text, sizeof(slot->text), "[{}]: ", getModId(mod)).out;
+    auto end = slot->text + sizeof(slot->text);
+    if (out < end) {
+        auto size = std::min<size_t>(message.size(), end - out);
+        std::memcpy(out, message.data(), size);
+        out += size;
+    }
+    slot->length = static_cast<uint16_t>(std::min(out, end) - slot->text);
+
+    slot->sequence.store(sequence, std::memory_order_release);
+}
+
+void FlightRecorder::recordTrace(const char* category, const char* name, int64_t durationUs) {
+    if (!m_header) return;
+
+    uint64_t sequence;
+    auto slot = claim(kTraceKind, sequence);
+    auto result = fmt::format_to_n(slot->text, sizeof(slot->text), "{}/{} {}us", category, name, durationUs);
+    slot->length = static_cast<uint16_t>(std::min(result.size, sizeof(slot->text)));
+
+    slot->sequence.store(sequence, std::memory_order_release);
+}
+
+void FlightRecorder::crash(LPEXCEPTION_POINTERS info) {
+    if (!m_header) return;
+
+    if (info && info->ExceptionRecord) {
+        m_trailer->exceptionCode = info->ExceptionRecord->ExceptionCode;
+        m_trailer->exceptionAddress = reinterpret_cast<uint64_t>(info->ExceptionRecord->ExceptionAddress);
+    }
+    m_trailer->crashMs = nowMs();
+    m_trailer->threadId = GetCurrentThreadId();
+    m_trailer->crashed = 1;
+
+    FlushViewOfFile(m_header, 0);
+}
+
+bool FlightRecorder::exportCrash(const std::filesystem::path& recording, const std::filesystem::path& out) {
+    auto res = utils::file::readBinary(recording);
+    if (!res) return false;
+    auto data = res.unwrap();
+    if (data.size() < kMappingSize) return false;
+
+    auto& header = *reinterpret_cast<const Header*>(data.data());
+    if (header.magic != kMagic || header.slotSize != kSlotSize || header.slotCount != kSlotCount) return false;
+
+    auto& trailer = *reinterpret_cast<const Trailer*>(data.data() + kSlotSize * (kSlotCount + 1));
+    if (!trailer.crashed) return false;
+
+    std::vector<const Slot*> slots;
+    for (size_t i = 0; i < kSlotCount; i++) {
+        auto slot = reinterpret_cast<const Slot*>(data.data() + kSlotSize * (i + 1));
+        if (slot->sequence.load(std::memory_order_relaxed) == 0) continue;
+        slots.push_back(slot);
+    }
+    std::sort(slots.begin(), slots.end(), [](const Slot* a, const Slot* b) {
+        return a->sequence.load(std::memory_order_relaxed) < b->sequence.load(std::memory_order_relaxed);
+    });
+
+    static constexpr std::array<const char*, 4> labels = {"DEBUG", "INFO ", "WARN ", "ERROR"};
+
+    std::string text;
+    for (auto slot : slots) {
+        auto time = std::chrono::system_clock::time_point(std::chrono::milliseconds(slot->ms));
+        auto label = slot->kind == kTraceKind ? "TRACE" : slot->kind < labels.size() ? labels[slot->kind] : "?????";
+        fmt::format_to(std::back_inserter(text), "{:%H:%M:%S}.{:03} {} [{}] {}\n",
+            sobriety::utils::convertTime(time), slot->ms % 1000, label, slot->threadId,
+            std::string_view(slot->text, std::min<size_t>(slot->length, sizeof(slot->text)))
+        );
+    }
+
+    auto time = std::chrono::system_clock::time_point(std::chrono::milliseconds(trailer.crashMs));
+    fmt::format_to(std::back_inserter(text), "{:%H:%M:%S}.{:03} Crashed with exception {:#010x} at {:#x} on thread {}\n",
+        sobriety::utils::convertTime(time), trailer.crashMs % 1000, trailer.exceptionCode, trailer.exceptionAddress, trailer.threadId
+    );
+
+    return utils::file::writeString(out, text).isOk();
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Geode/loader/Mod.hpp>
+#include <atomic>
+#include <filesystem>
+#include <string_view>
+
+/*
+    The last few thousand log lines and trace events, kept in a fixed ring inside a file mapping in the session
+    directory. Since the pages belong to the file they outlive the process, so whatever was logged right before
+    a crash survives even if the sink never wrote it.
+
+    Only lines that pass the console filter are recorded, and never formatted just for the recorder. An eagerly
+    formatted line is copied from the text the sink is given, a deferred one from the text the writer renders,
+    so a deferred line still queued in the sink at the crash is missing. Lines nothing else formats (no sink,
+    or one that's dropping them) are formatted straight into the slot.
+
+    The exception handler only stamps the trailer and flushes the view, it never allocates. A later launch turns
+    the ring of a crashed session into crash.log next to it (see SessionDirectory::collect).
+*/
+class FlightRecorder {
+public:
+    static constexpr uint64_t kMagic = 0x31544c4652424f53; // SOBRFLT1
+    static constexpr size_t kSlotSize = 256;
+    static constexpr size_t kSlotCount = 4096;
+    static constexpr uint8_t kTraceKind = 0xff;
+
+    struct Header {
+        uint64_t magic;
+        uint32_t slotSize;
+        uint32_t slotCount;
+        std::atomic<uint64_t> next;
+    };
+
+    struct Slot {
+        // index + 1 once the slot is complete, 0 while it's being written
+        std::atomic<uint64_t> sequence;
+        int64_t ms;
+        uint32_t threadId;
+        uint16_t length;
+        // the severity, or kTraceKind
+        uint8_t kind;
+        uint8_t reserved;
+        char text[kSlotSize - 24];
+    };
+
+    struct Trailer {
+        uint32_t crashed;
+        uint32_t exceptionCode;
+        uint64_t exceptionAddress;
+        int64_t crashMs;
+        uint32_t threadId;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(Slot) == kSlotSize);
+
+    static FlightRecorder* get();
+
+    void setup(const std::filesystem::path& path);
+    void record(geode::Severity severity, geode::Mod* mod, fmt::string_view format, fmt::format_args args);
+    // ms and threadId are those of the thread that logged the line, 0 for the current one
+    void record(geode::Severity severity, geode::Mod* mod, std::string_view message, int64_t ms = 0, uint32_t threadId = 0);
+    void recordTrace(const char* category, const char* name, int64_t durationUs);
+    // safe to call from the unhandled exception filter
+    void crash(LPEXCEPTION_POINTERS info);
+
+    // false when the file isn't a recording of a crashed session
+    static bool exportCrash(const std::filesystem::path& recording, const std::filesystem::path& out);
+
+private:
+    Slot* claim(uint8_t kind, uint64_t& sequence);
+    static const std::string& getModId(geode::Mod* mod);
+
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+    Header* m_header = nullptr;
+    Slot* m_slots = nullptr;
+    Trailer* m_trailer = nullptr;
+};
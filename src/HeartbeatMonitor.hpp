@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+/*
+    Tracks the gaps between console heartbeats and derives how long a silence has to last before the console
+    counts as gone. Same idea as TCP's retransmit timer: smoothed interval plus four times its deviation,
+    clamped between a few expected intervals and the user's configured threshold.
+*/
+class HeartbeatMonitor {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Duration = std::chrono::duration<double, std::milli>;
+
+    HeartbeatMonitor(Duration expectedInterval, Duration maxThreshold) {
+        m_expected = expectedInterval;
+        m_maxThreshold = maxThreshold;
+        m_smoothed = expectedInterval;
+        m_deviation = expectedInterval / 2;
+    }
+
+    void beat(Clock::time_point now) {
+        if (m_lastBeat != Clock::time_point{}) {
+            Duration interval = now - m_lastBeat;
+            auto error = interval - m_smoothed;
+            m_smoothed += error / 8;
+            m_deviation += (Duration(std::abs(error.count())) - m_deviation) / 4;
+        }
+        m_lastBeat = now;
+    }
+
+    Duration getThreshold() const {
+        auto threshold = m_smoothed + m_deviation * 4;
+        return std::clamp(threshold, std::min(m_expected * 4, m_maxThreshold), m_maxThreshold);
+    }
+
+    Duration getExpectedInterval() const {
+        return m_expected;
+    }
+
+    bool isDead(Clock::time_point now) const {
+        return now - m_lastBeat > getThreshold();
+    }
+
+private:
+    Duration m_expected;
+    Duration m_maxThreshold;
+    Duration m_smoothed;
+    Duration m_deviation;
+    Clock::time_point m_lastBeat;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+
+/*
+    Log-linear buckets over microseconds, eight per power of two, so any percentile is within 12.5% of the
+    true value. Recording is a couple of relaxed atomic adds and safe from any thread.
+*/
+class LatencyHistogram {
+public:
+    static constexpr size_t kSubBuckets = 8;
+    static constexpr size_t kBucketCount = 40 * kSubBuckets;
+
+    void record(std::chrono::steady_clock::duration duration) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        auto value = static_cast<uint64_t>(std::max<int64_t>(us, 0));
+
+        m_buckets[getBucket(value)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+
+        auto max = m_max.load(std::memory_order_relaxed);
+        while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed));
+    }
+
+    uint64_t getCount() const {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getSum() const {
+        return m_sum.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getMax() const {
+        return m_max.load(std::memory_order_relaxed);
+    }
+
+    // microseconds, the upper bound of the bucket the percentile falls in
+    uint64_t getPercentile(double percentile) const {
+        auto count = getCount();
+        if (count == 0) return 0;
+
+        auto target = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(count - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; i++) {
+            seen += m_buckets[i].load(std::memory_order_relaxed);
+            if (seen >= target) return std::min(getUpperBound(i), getMax());
+        }
+        return getMax();
+    }
+
+    // only safe while nothing is recording
+    void reset() {
+        for (auto& bucket : m_buckets) bucket.store(0, std::memory_order_relaxed);
+        m_count.store(0, std::memory_order_relaxed);
+        m_sum.store(0, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static size_t getBucket(uint64_t value) {
+        if (value < kSubBuckets) return static_cast<size_t>(value);
+
+        auto magnitude = static_cast<size_t>(std::bit_width(value)) - 1;
+        auto sub = static_cast<size_t>(value >> (magnitude - 3)) & (kSubBuckets - 1);
+        return std::min((magnitude - 2) * kSubBuckets + sub, kBucketCount - 1);
+    }
+
+    static uint64_t getUpperBound(size_t bucket) {
+        if (bucket < kSubBuckets) return bucket;
+
+        auto magnitude = bucket / kSubBuckets + 2;
+        auto sub = bucket % kSubBuckets;
+        return ((kSubBuckets + sub + 1) << (magnitude - 3)) - 1;
+    }
+
+    std::array<std::atomic<uint64_t>, kBucketCount> m_buckets{};
+    std::atomic<uint64_t> m_count = 0;
+    std::atomic<uint64_t> m_sum = 0;
+    std::atomic<uint64_t> m_max = 0;
+};
@@ -0,0 +1,115 @@
+#include <Geode/Geode.hpp>
+#include "LogArchiver.hpp"
+
+using namespace geode::prelude;
+
+LogArchiver::LogArchiver(const std::filesystem::path& directory, size_t maxPending, uintmax_t maxArchiveBytes) {
+    m_directory = directory;
+    m_maxPending = std::max<size_t>(maxPending, 1);
+    m_maxArchiveBytes = maxArchiveBytes;
+    m_thread = std::thread([this] {
+        thread::setName("Sobriety Log Archiver");
+        run();
+    });
+}
+
+LogArchiver::~LogArchiver() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_running = false;
+    }
+    m_cv.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void LogArchiver::push(const std::filesystem::path& segment) {
+    {
+        std::lock_guard lock(m_mutex);
+        m_pending.push_back(segment);
+        while (m_kept.size() + m_pending.size() > m_maxPending) {
+            auto& oldest = m_kept.empty() ? m_pending : m_kept;
+            std::error_code ec;
+            std::filesystem::remove(oldest.front(), ec);
+            oldest.pop_front();
+        }
+    }
+    m_cv.notify_one();
+}
+
+void LogArchiver::run() {
+    while (true) {
+        std::filesystem::path segment;
+        {
+            std::unique_lock lock(m_mutex);
+            m_cv.wait(lock, [this] { return !m_running || !m_pending.empty(); });
+            if (m_pending.empty()) return;
+            segment = m_pending.front();
+        }
+
+        auto archived = archive(segment);
+
+        std::lock_guard lock(m_mutex);
+        if (m_pending.empty() || m_pending.front() != segment) continue;
+        m_pending.pop_front();
+        if (!archived) m_kept.push_back(segment);
+    }
+}
+
+/*
+    The zip is only written out when it's closed, so it's opened again to check the segment made it in
+    before the segment is deleted. A segment that didn't is left where it is.
+*/
+bool LogArchiver::archive(const std::filesystem::path& segment) {
+    std::error_code ec;
+    std::filesystem::create_directories(m_directory, ec);
+
+    auto zipPath = m_directory / segment.filename();
+    zipPath.replace_extension(".zip");
+
+    auto zipName = utils::string::pathToString(zipPath);
+    auto segmentName = utils::string::pathToString(segment);
+
+    bool added = false;
+    {
+        auto zipRes = file::Zip::create(zipPath);
+        if (!zipRes) {
+            log::error("Failed to create {}: {}", zipName, zipRes.unwrapErr());
+            return false;
+        }
+        auto zip = std::move(zipRes).unwrap();
+        auto addRes = zip.addFrom(segment);
+        if (addRes) added = true;
+        else log::error("Failed to archive {}: {}", segmentName, addRes.unwrapErr());
+    }
+
+    if (!added) {
+        std::filesystem::remove(zipPath, ec);
+        return false;
+    }
+
+    auto unzipRes = file::Unzip::create(zipPath);
+    if (!unzipRes || !unzipRes.unwrap().hasEntry(segment.filename())) {
+        log::error("Failed to write {}, keeping {}", zipName, segmentName);
+        std::filesystem::remove(zipPath, ec);
+        return false;
+    }
+
+    std::filesystem::remove(segment, ec);
+    prune(zipPath);
+    return true;
+}
+
+void LogArchiver::prune(const std::filesystem::path& zipPath) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(zipPath, ec);
+    if (ec) size = 0;
+    m_archives.emplace_back(zipPath, size);
+    m_archiveBytes += size;
+
+    // the newest archive always stays, even if it's over the cap on its own
+    while (m_archives.size() > 1 && m_archiveBytes > m_maxArchiveBytes) {
+        std::filesystem::remove(m_archives.front().first, ec);
+        m_archiveBytes -= m_archives.front().second;
+        m_archives.pop_front();
+    }
+}
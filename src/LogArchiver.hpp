@@ -0,0 +1,39 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+/*
+    Compresses closed log segments into the session archive on its own thread. Segments waiting for it, and
+    ones it failed to compress and kept as they are, still count against the segment cap, so if it falls too
+    far behind the oldest ones are dropped instead. Archives are capped by their total size, the oldest go first.
+*/
+class LogArchiver {
+public:
+    LogArchiver(const std::filesystem::path& directory, size_t maxPending, uintmax_t maxArchiveBytes);
+    ~LogArchiver();
+
+    void push(const std::filesystem::path& segment);
+
+private:
+    void run();
+    bool archive(const std::filesystem::path& segment);
+    void prune(const std::filesystem::path& zipPath);
+
+    std::filesystem::path m_directory;
+    size_t m_maxPending;
+    uintmax_t m_maxArchiveBytes;
+    std::deque<std::filesystem::path> m_pending;
+    std::deque<std::filesystem::path> m_kept;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_running = true;
+    std::thread m_thread;
+
+    // archiver thread only, oldest first
+    std::deque<std::pair<std::filesystem::path, uintmax_t>> m_archives;
+    uintmax_t m_archiveBytes = 0;
+};
@@ -0,0 +1,100 @@
+#include <Geode/Geode.hpp>
+#include "LogFormatter.hpp"
+#include "Config.hpp"
+#include "Utils.hpp"
+
+using namespace geode::prelude;
+
+struct SeverityStyle {
+    std::string_view color;
+    std::string_view label;
+};
+
+static constexpr SeverityStyle getSeverityStyle(int severity) {
+    switch (severity) {
+        case Severity::Debug: return {"\033[38;5;243m", " DEBUG"};
+        case Severity::Info: return {"\033[38;5;33m", " INFO "};
+        case Severity::Warning: return {"\033[38;5;229m", " WARN "};
+        case Severity::Error: return {"\033[38;5;9m", " ERROR"};
+        default: return {"\033[38;5;7m", " ?????"};
+    }
+}
+
+/*
+    The wall clock text only changes once a second, so each thread keeps the last rendered HH:MM:SS around
+    and refreshes its thread name at the same time instead of asking geode for it on every line.
+*/
+struct ThreadLogState {
+    fmt::memory_buffer buffer;
+    long long second = -1;
+    char clock[8];
+    long long nameSecond = -1;
+    std::string threadName;
+    std::unordered_map<Mod*, std::string> modNames;
+};
+
+static thread_local ThreadLogState t_state;
+
+static void append(fmt::memory_buffer& buffer, std::string_view str) {
+    buffer.append(str.data(), str.data() + str.size());
+}
+
+std::string_view LogFormatter::format(Severity severity, Mod* mod, fmt::string_view format, fmt::format_args args, size_t* messageStart) {
+    auto& state = t_state;
+    state.buffer.clear();
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+
+    if (ms / 1000 != state.nameSecond) {
+        state.threadName = thread::getName();
+        state.nameSecond = ms / 1000;
+    }
+
+    auto start = formatTo(state.buffer, severity, mod, state.threadName, ms, format, args);
+    if (messageStart) *messageStart = start;
+    return std::string_view(state.buffer.data(), state.buffer.size());
+}
+
+size_t LogFormatter::formatTo(
+    fmt::memory_buffer& buffer, Severity severity, Mod* mod, std::string_view threadName,
+    long long ms, fmt::string_view format, fmt::format_args args
+) {
+    auto& state = t_state;
+    auto second = ms / 1000;
+
+    if (second != state.second) {
+        auto time = std::chrono::system_clock::time_point(std::chrono::milliseconds(ms));
+        fmt::format_to(state.clock, "{:%H:%M:%S}", sobriety::utils::convertTime(time));
+        state.second = second;
+    }
+
+    auto iter = state.modNames.find(mod);
+    if (iter == state.modNames.end()) {
+        iter = state.modNames.emplace(mod, mod->getName()).first;
+    }
+
+    auto style = getSeverityStyle(severity.m_value);
+    append(buffer, style.color);
+    append(buffer, std::string_view(state.clock, sizeof(state.clock)));
+    if (Config::get()->shouldLogMillisconds()) {
+        auto millis = ms % 1000;
+        char frac[4] = {'.', char('0' + millis / 100), char('0' + millis / 10 % 10), char('0' + millis % 10)};
+        append(buffer, std::string_view(frac, sizeof(frac)));
+    }
+    append(buffer, style.label);
+    append(buffer, "\033[0m [");
+
+    if (!threadName.empty()) {
+        append(buffer, threadName);
+        append(buffer, "] [");
+    }
+    append(buffer, iter->second);
+    append(buffer, "]: ");
+
+    auto messageStart = buffer.size();
+    fmt::vformat_to(fmt::appender(buffer), format, args);
+    buffer.push_back('\n');
+    return messageStart;
+}
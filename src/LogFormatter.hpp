@@ -0,0 +1,23 @@
+#pragma once
+
+#include <Geode/loader/Mod.hpp>
+#include <string_view>
+
+/*
+    Renders a console line (colour, timestamp, severity, thread, mod and message) in a single pass into a
+    reusable thread local buffer. The returned view is valid until the next call on the same thread.
+    messageStart is where the message itself starts, it runs up to the trailing newline.
+*/
+class LogFormatter {
+public:
+    static std::string_view format(
+        geode::Severity severity, geode::Mod* mod, fmt::string_view format, fmt::format_args args, size_t* messageStart = nullptr
+    );
+
+    // for lines captured on another thread, timestamp and thread name are the ones the line was logged with,
+    // returns where the message starts in the buffer
+    static size_t formatTo(
+        fmt::memory_buffer& buffer, geode::Severity severity, geode::Mod* mod, std::string_view threadName,
+        long long ms, fmt::string_view format, fmt::format_args args
+    );
+};
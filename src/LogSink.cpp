@@ -0,0 +1,556 @@
+#include <Geode/Geode.hpp>
+#include "LogSink.hpp"
+#include "DeferredLog.hpp"
+#include "FlightRecorder.hpp"
+#include "Metrics.hpp"
+#include "Tracer.hpp"
+
+using namespace geode::prelude;
+
+LogSink::LogSink(std::vector<LogTarget> targets, OverflowPolicy policy) {
+    for (size_t i = 0; i < kLaneCount; i++) {
+        auto& lane = m_lanes[i];
+        lane.slots = std::make_unique<Slot[]>(kLaneCapacity);
+        for (size_t j = 0; j < kLaneCapacity; j++) {
+            lane.slots[j].sequence.store(j, std::memory_order_relaxed);
+        }
+        lane.policy = i >= getLaneIndex(Severity::Warning) ? OverflowPolicy::Block : policy;
+    }
+    m_batch.reserve(kFlushBytes * 2);
+
+    for (auto& target : targets) {
+        auto& output = m_outputs.emplace_back(Output{std::move(target)});
+        if (output.target.kind != LogTarget::Kind::File) continue;
+
+        if (output.target.segmentBytes > 0 && !m_archiver) {
+            m_archiver = std::make_unique<LogArchiver>(
+                output.target.path.parent_path() / "archive",
+                output.target.segmentCount > 1 ? output.target.segmentCount - 1 : 1,
+                static_cast<uintmax_t>(output.target.segmentBytes) * std::max<size_t>(output.target.segmentCount, 1)
+            );
+        }
+
+        output.handle = CreateFileW(
+            output.target.path.c_str(),
+            FILE_APPEND_DATA,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr,
+            OPEN_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr
+        );
+
+        if (output.handle == INVALID_HANDLE_VALUE) {
+            log::error("Failed to open log sink file: {}", GetLastError());
+            output.closed = true;
+            continue;
+        }
+
+        if (output.target.indexed) {
+            output.index = openIndex(output);
+            if (output.index == INVALID_HANDLE_VALUE) log::error("Failed to open log index: {}", GetLastError());
+            else m_indexed = true;
+        }
+    }
+
+    if (m_indexed) {
+        auto& first = *std::find_if(m_outputs.begin(), m_outputs.end(), [](const Output& output) {
+            return output.index != INVALID_HANDLE_VALUE;
+        });
+        m_modTable = CreateFileW(
+            (first.target.path.parent_path() / "console.mods").c_str(),
+            GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_DELETE,
+            nullptr,
+            CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr
+        );
+    }
+
+    m_wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    m_thread = std::thread([this] {
+        thread::setName("Sobriety Log Sink");
+        run();
+    });
+}
+
+LogSink::~LogSink() {
+    m_running.store(false, std::memory_order_release);
+    if (m_wakeEvent) SetEvent(m_wakeEvent);
+    if (m_thread.joinable()) m_thread.join();
+
+    for (auto& output : m_outputs) {
+        if (output.handle != INVALID_HANDLE_VALUE) CloseHandle(output.handle);
+        if (output.index != INVALID_HANDLE_VALUE) CloseHandle(output.index);
+    }
+    if (m_modTable != INVALID_HANDLE_VALUE) CloseHandle(m_modTable);
+    if (m_wakeEvent) CloseHandle(m_wakeEvent);
+}
+
+size_t LogSink::getLaneIndex(Severity severity) {
+    return static_cast<size_t>(std::clamp<int>(severity.m_value, 0, kLaneCount - 1));
+}
+
+void LogSink::append(std::string_view data, Severity severity, Mod* mod) {
+    TraceSpan span("sink", "LogSink::append");
+    push(data, severity, mod, false);
+}
+
+bool LogSink::appendDeferred(Severity severity, Mod* mod, fmt::string_view format, fmt::format_args args) {
+    TraceSpan span("sink", "LogSink::appendDeferred");
+
+    auto record = DeferredLog::capture(severity, mod, format, args);
+    if (record.empty()) return false;
+
+    push(record, severity, mod, true);
+    return true;
+}
+
+void LogSink::push(std::string_view data, Severity severity, Mod* mod, bool deferred) {
+    auto& lane = m_lanes[getLaneIndex(severity)];
+    auto pending = m_pendingBytes.fetch_add(data.size(), std::memory_order_relaxed) + data.size();
+    std::chrono::steady_clock::time_point shedDeadline;
+
+    while (!tryPush(lane, data, mod, deferred)) {
+        switch (lane.policy) {
+            case OverflowPolicy::Block: {
+                // the writer is behind, wake it and wait for a free slot
+                SetEvent(m_wakeEvent);
+                std::this_thread::yield();
+                break;
+            }
+            case OverflowPolicy::DropOldest: {
+                // only the writer dequeues, so it's asked to throw away the oldest half of the lane and the push
+                // is retried once there's room. The new line is only lost if the writer can't get to it in time.
+                auto now = std::chrono::steady_clock::now();
+                if (shedDeadline == std::chrono::steady_clock::time_point{}) shedDeadline = now + kShedWait;
+                if (now < shedDeadline) {
+                    if (!lane.shed.load(std::memory_order_relaxed) && !lane.shed.exchange(true, std::memory_order_relaxed)) {
+                        SetEvent(m_wakeEvent);
+                    }
+                    std::this_thread::yield();
+                    break;
+                }
+
+                m_pendingBytes.fetch_sub(data.size(), std::memory_order_relaxed);
+                lane.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            case OverflowPolicy::DropNewest: {
+                m_pendingBytes.fetch_sub(data.size(), std::memory_order_relaxed);
+                lane.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    if (severity >= Severity::Error || (pending >= kFlushBytes && pending - data.size() < kFlushBytes)) {
+        SetEvent(m_wakeEvent);
+    }
+}
+
+bool LogSink::isAccepting(Severity severity) {
+    auto& lane = m_lanes[getLaneIndex(severity)];
+    if (lane.policy != OverflowPolicy::DropNewest) return true;
+
+    auto queued = lane.enqueuePos.load(std::memory_order_relaxed) - lane.dequeuePos.load(std::memory_order_relaxed);
+    if (queued < kLaneCapacity) return true;
+
+    lane.dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void LogSink::flush() {
+    SetEvent(m_wakeEvent);
+}
+
+bool LogSink::flushAndWait(std::chrono::milliseconds timeout) {
+    std::unique_lock lock(m_flushMutex);
+    auto request = ++m_flushRequested;
+    SetEvent(m_wakeEvent);
+    return m_flushed.wait_for(lock, timeout, [&] { return m_flushCompleted >= request; });
+}
+
+size_t LogSink::getQueueDepth() const {
+    size_t depth = 0;
+    for (auto& lane : m_lanes) {
+        auto enqueued = lane.enqueuePos.load(std::memory_order_relaxed);
+        auto dequeued = lane.dequeuePos.load(std::memory_order_relaxed);
+        if (enqueued > dequeued) depth += enqueued - dequeued;
+    }
+    return depth;
+}
+
+size_t LogSink::getPendingBytes() const {
+    return m_pendingBytes.load(std::memory_order_relaxed);
+}
+
+/*
+    Bounded MPMC ring by Dmitry Vyukov, each slot carries a sequence number so the writer and producers never
+    touch each other's data. The writer is the only consumer.
+
+    The order is taken after reading the position and before claiming it, so a claim that succeeds always
+    holds a higher order than the one before it and orders increase along a lane without a lock. A producer
+    that loses the race takes a new order, the one it had is left as a gap.
+*/
+bool LogSink::tryPush(Lane& lane, std::string_view data, Mod* mod, bool deferred) {
+    Slot* slot;
+    size_t pos = lane.enqueuePos.load(std::memory_order_seq_cst);
+
+    while (true) {
+        slot = &lane.slots[pos & (kLaneCapacity - 1)];
+        auto diff = static_cast<intptr_t>(slot->sequence.load(std::memory_order_acquire)) - static_cast<intptr_t>(pos);
+
+        if (diff == 0) {
+            auto order = m_nextOrder.fetch_add(1, std::memory_order_seq_cst);
+            if (lane.enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_seq_cst)) {
+                slot->order.store(order, std::memory_order_relaxed);
+                break;
+            }
+        }
+        else if (diff < 0) {
+            return false;
+        }
+        else {
+            pos = lane.enqueuePos.load(std::memory_order_seq_cst);
+        }
+    }
+
+    slot->size = static_cast<uint32_t>(data.size());
+    slot->deferred = deferred;
+    slot->mod = mod;
+    slot->queued = std::chrono::steady_clock::now();
+    slot->ms = m_indexed ? std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count() : 0;
+    if (data.size() <= kInlineSize) {
+        std::memcpy(slot->data.data(), data.data(), data.size());
+    }
+    else {
+        slot->overflow.assign(data);
+    }
+
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+void LogSink::take(Lane& lane, size_t pos) {
+    lane.dequeuePos.store(pos + 1, std::memory_order_relaxed);
+
+    auto& slot = lane.slots[pos & (kLaneCapacity - 1)];
+    static auto& queueDelay = Metrics::get()->histogram("sobriety_sink_queue_delay_seconds", "A line queued in the sink until the writer takes it");
+    queueDelay.record(std::chrono::steady_clock::now() - slot.queued);
+
+    if (!m_indexed) {
+        release(lane, pos, &m_batch);
+        return;
+    }
+
+    IndexEntry entry{};
+    entry.offset = m_batch.size();
+    entry.ms = slot.ms;
+    entry.severity = static_cast<uint8_t>(&lane - m_lanes.data());
+    entry.mod = getModIndex(slot.mod);
+
+    release(lane, pos, &m_batch);
+    entry.length = static_cast<uint32_t>(m_batch.size() - entry.offset);
+    m_batchIndex.push_back(entry);
+}
+
+/*
+    A DropOldest lane that filled up is cut down to half its capacity from the oldest end, so the lines logged
+    after the flood get through instead of the ones the writer was already behind on.
+*/
+void LogSink::shed() {
+    for (auto& lane : m_lanes) {
+        if (!lane.shed.exchange(false, std::memory_order_relaxed)) continue;
+
+        uint64_t order;
+        size_t pos;
+        while (peekOrder(lane, order, pos) == Head::Ready
+            && lane.enqueuePos.load(std::memory_order_relaxed) - pos > kLaneCapacity / 2) {
+            lane.dequeuePos.store(pos + 1, std::memory_order_relaxed);
+            release(lane, pos, nullptr);
+            lane.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+// out is null when the line is being dropped, deferred lines are rendered into it
+void LogSink::release(Lane& lane, size_t pos, std::string* out) {
+    auto slot = &lane.slots[pos & (kLaneCapacity - 1)];
+
+    auto data = slot->size <= kInlineSize ? std::string_view(slot->data.data(), slot->size) : std::string_view(slot->overflow);
+    if (out && slot->deferred) {
+        m_render.clear();
+        auto line = DeferredLog::render(m_render, data);
+        FlightRecorder::get()->record(line.severity, line.mod, line.message, line.ms, line.threadId);
+        out->append(m_render.data(), m_render.size());
+    }
+    else if (out) {
+        out->append(data);
+    }
+    if (slot->size > kInlineSize) slot->overflow.clear();
+    m_pendingBytes.fetch_sub(slot->size, std::memory_order_relaxed);
+
+    slot->sequence.store(pos + kLaneCapacity, std::memory_order_release);
+}
+
+/*
+    A head that's claimed but still being written could be older than every other lane's head. Its order is
+    stored right after the claim, until then the slot still holds an order from an earlier lap, which is lower,
+    so a pending order is never later than the line's real one.
+*/
+LogSink::Head LogSink::peekOrder(Lane& lane, uint64_t& order, size_t& pos) {
+    pos = lane.dequeuePos.load(std::memory_order_relaxed);
+    auto& slot = lane.slots[pos & (kLaneCapacity - 1)];
+    order = slot.order.load(std::memory_order_relaxed);
+
+    if (slot.sequence.load(std::memory_order_acquire) == pos + 1) return Head::Ready;
+    return lane.enqueuePos.load(std::memory_order_seq_cst) > pos ? Head::Pending : Head::Empty;
+}
+
+void LogSink::appendDropNotices() {
+    static constexpr std::array<const char*, kLaneCount> names = {"debug", "info", "warning", "error"};
+    static auto counters = [] {
+        std::array<Metrics::Counter*, kLaneCount> counters;
+        for (size_t i = 0; i < kLaneCount; i++) {
+            counters[i] = &Metrics::get()->counter("sobriety_sink_dropped_lines_total", "Lines the sink threw away because a lane was full", {{"severity", names[i]}});
+        }
+        return counters;
+    }();
+
+    for (size_t i = 0; i < kLaneCount; i++) {
+        auto dropped = m_lanes[i].dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped == 0) continue;
+        counters[i]->add(dropped);
+
+        fmt::format_to(std::back_inserter(m_batch), "\033[38;5;243m[Sobriety] {} {} line{} dropped\033[0m\n",
+            dropped, names[i], dropped == 1 ? "" : "s"
+        );
+    }
+}
+
+void LogSink::run() {
+    while (m_running.load(std::memory_order_acquire)) {
+        WaitForSingleObject(m_wakeEvent, static_cast<DWORD>(kFlushInterval.count()));
+        connect();
+
+        // every line appended before the request was claimed before it's read here, so a complete drain covers them
+        uint64_t requested;
+        {
+            std::lock_guard lock(m_flushMutex);
+            requested = m_flushRequested;
+        }
+        if (drain() && requested != m_flushCompleted) {
+            std::lock_guard lock(m_flushMutex);
+            m_flushCompleted = requested;
+            m_flushed.notify_all();
+        }
+    }
+    // producers are done by now, a line can only still be pending if one was stopped halfway through a push
+    for (int i = 0; i < 1000 && !drain(); i++) {
+        std::this_thread::yield();
+    }
+}
+
+/*
+    The console script only moves the fifo into place once it holds a reader on it, so if it exists,
+    opening it for writing won't block.
+*/
+void LogSink::connect() {
+    for (auto& output : m_outputs) {
+        if (output.target.kind != LogTarget::Kind::Pipe) continue;
+        if (output.closed || output.handle != INVALID_HANDLE_VALUE) continue;
+        if (GetFileAttributesW(output.target.path.c_str()) == INVALID_FILE_ATTRIBUTES) continue;
+
+        output.handle = CreateFileW(
+            output.target.path.c_str(),
+            GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_WRITE,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr
+        );
+        if (output.handle == INVALID_HANDLE_VALUE) continue;
+
+        if (!writeAll(output.handle, output.backlog)) {
+            CloseHandle(output.handle);
+            output.handle = INVALID_HANDLE_VALUE;
+            output.closed = true;
+        }
+        std::string().swap(output.backlog);
+    }
+}
+
+/*
+    Merges the lanes by order. A line that's still being written holds back everything logged after it, the
+    writer doesn't wait for it but leaves the rest for its next wake. Returns false when that happened.
+*/
+bool LogSink::drain() {
+    shed();
+    appendDropNotices();
+
+    bool complete = true;
+    while (true) {
+        // a lane that looked empty can take an older line than the one picked while the others are scanned,
+        // anything claimed before the scan started can't be overtaken like that
+        auto horizon = m_nextOrder.load(std::memory_order_seq_cst);
+        auto limit = horizon;
+        Lane* next = nullptr;
+        uint64_t nextOrder = UINT64_MAX;
+        size_t nextPos = 0;
+        for (auto& lane : m_lanes) {
+            uint64_t order;
+            size_t pos;
+            auto head = peekOrder(lane, order, pos);
+            if (head == Head::Pending) limit = std::min(limit, order);
+            if (head == Head::Ready && order < nextOrder) {
+                next = &lane;
+                nextOrder = order;
+                nextPos = pos;
+            }
+        }
+        if (limit < horizon) complete = false;
+        if (!next) break;
+        if (nextOrder >= limit) {
+            // the horizon alone only holds back lines claimed during the scan, those are taken right away
+            if (limit < horizon) break;
+            continue;
+        }
+        take(*next, nextPos);
+
+        if (m_batch.size() >= kFlushBytes) {
+            write();
+            appendDropNotices();
+        }
+    }
+    write();
+    return complete;
+}
+
+void LogSink::write() {
+    if (m_batch.empty()) return;
+    TraceSpan span("sink", "LogSink::write");
+
+    static auto& bytesWritten = Metrics::get()->counter("sobriety_sink_written_bytes_total", "Bytes the sink handed to its outputs");
+    static auto& writeTime = Metrics::get()->histogram("sobriety_sink_write_seconds", "Time to write one batch to every output");
+    auto writeStart = std::chrono::steady_clock::now();
+    bytesWritten.add(m_batch.size());
+
+    for (auto& output : m_outputs) {
+        if (output.closed) continue;
+
+        if (output.handle == INVALID_HANDLE_VALUE) {
+            if (output.backlog.size() + m_batch.size() <= kMaxBacklog) output.backlog += m_batch;
+            continue;
+        }
+
+        // a failed write to the pipe means the console went away, there's nobody left to read it
+        if (!writeAll(output.handle, m_batch) && output.target.kind == LogTarget::Kind::Pipe) {
+            CloseHandle(output.handle);
+            output.handle = INVALID_HANDLE_VALUE;
+            output.closed = true;
+            continue;
+        }
+
+        if (output.index != INVALID_HANDLE_VALUE && !m_batchIndex.empty()) {
+            m_indexOutput.assign(m_batchIndex.begin(), m_batchIndex.end());
+            for (auto& entry : m_indexOutput) entry.offset += output.written;
+            writeAll(output.index, std::string_view(
+                reinterpret_cast<const char*>(m_indexOutput.data()), m_indexOutput.size() * sizeof(IndexEntry)
+            ));
+        }
+
+        output.written += m_batch.size();
+        if (output.target.segmentBytes > 0 && output.written >= output.target.segmentBytes) {
+            rotate(output);
+        }
+    }
+
+    m_batch.clear();
+    m_batchIndex.clear();
+    writeTime.record(std::chrono::steady_clock::now() - writeStart);
+}
+
+bool LogSink::writeAll(HANDLE handle, std::string_view data) {
+    while (!data.empty()) {
+        DWORD written = 0;
+        if (!WriteFile(handle, data.data(), static_cast<DWORD>(data.size()), &written, nullptr) || written == 0) {
+            return false;
+        }
+        data.remove_prefix(written);
+    }
+    return true;
+}
+
+/*
+    Segments are rotated by renaming the live file and starting a new one under the same name. tail -F notices
+    the rename, reads what's left of the old file and then follows the new one, so the console doesn't lose lines.
+*/
+void LogSink::rotate(Output& output) {
+    CloseHandle(output.handle);
+    output.handle = INVALID_HANDLE_VALUE;
+
+    auto& path = output.target.path;
+    auto segmentPath = path.parent_path() / fmt::format("{}.{}{}",
+        utils::string::pathToString(path.stem()),
+        ++output.segment,
+        utils::string::pathToString(path.extension())
+    );
+
+    if (MoveFileExW(path.c_str(), segmentPath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        m_archiver->push(segmentPath);
+    }
+
+    output.handle = CreateFileW(
+        path.c_str(),
+        FILE_APPEND_DATA,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    output.written = 0;
+
+    if (output.handle == INVALID_HANDLE_VALUE) output.closed = true;
+
+    if (output.index != INVALID_HANDLE_VALUE) {
+        CloseHandle(output.index);
+        output.index = openIndex(output);
+    }
+}
+
+HANDLE LogSink::openIndex(const Output& output) {
+    auto path = output.target.path;
+    path.replace_extension(".idx");
+    return CreateFileW(
+        path.c_str(),
+        FILE_APPEND_DATA,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+}
+
+// only the writer numbers mods, so there's nothing to synchronise
+uint16_t LogSink::getModIndex(Mod* mod) {
+    if (!mod) return kNoMod;
+
+    auto iter = m_modIndices.find(mod);
+    if (iter != m_modIndices.end()) return iter->second;
+
+    if (m_modIndices.size() >= kNoMod) return kNoMod;
+    auto index = static_cast<uint16_t>(m_modIndices.size());
+    m_modIndices.emplace(mod, index);
+
+    if (m_modTable != INVALID_HANDLE_VALUE) {
+        writeAll(m_modTable, fmt::format("{}\t{}\n", index, mod->getID()));
+    }
+    return index;
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <Geode/loader/Mod.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "LogArchiver.hpp"
+#include "OverflowPolicy.hpp"
+
+struct LogTarget {
+    enum class Kind {
+        File,
+        Pipe
+    };
+
+    std::filesystem::path path;
+    Kind kind = Kind::File;
+    // file targets roll over into numbered segments past this size, 0 keeps a single file
+    size_t segmentBytes = 0;
+    size_t segmentCount = 0;
+    // keep a .idx sidecar for the live file, see LogSink::IndexEntry
+    bool indexed = false;
+};
+
+/*
+    Producers push lines into bounded lock-free rings and a single writer thread drains them in batches,
+    so logging from the main thread costs a memcpy instead of a write through wine's file layer.
+
+    Each severity gets its own ring, so a flood of debug lines can only ever push out other debug lines.
+    Warnings and errors always block instead of dropping, the other lanes follow the configured policy and
+    the writer reports how many lines were dropped inline. Lines carry a global order so the writer can
+    merge the lanes back into the order they were logged in. Neither side ever waits on the other's lock, a
+    producer stopped halfway through a push only holds back the lines logged after it until the writer's
+    next wake.
+
+    Deferred lines hold a captured record instead of text (see DeferredLog), the writer renders them as it
+    drains and hands the text to the flight recorder as well, so the logging thread never runs the formatter.
+
+    Indexed file targets get a sidecar with an entry per line, so a query can binary search it by time and
+    read only the byte ranges it wants instead of scanning the whole file. The index follows the live file,
+    it starts over when the file is rotated. Mods are numbered in the order they first log, the table of
+    numbers to ids is kept in console.mods next to it.
+
+    Pipe targets are opened by the writer once the console has created them, anything written before that
+    is held in a backlog and replayed so early startup logs still make it to the console.
+*/
+class LogSink {
+public:
+    static constexpr size_t kLaneCount = 4;
+    static constexpr size_t kLaneCapacity = 1024;
+    static constexpr size_t kInlineSize = 256;
+    static constexpr size_t kFlushBytes = 64 * 1024;
+    static constexpr size_t kMaxBacklog = 4 * 1024 * 1024;
+    static constexpr auto kFlushInterval = std::chrono::milliseconds(50);
+    // how long a DropOldest producer waits for the writer to shed before it drops its own line
+    static constexpr auto kShedWait = std::chrono::milliseconds(2);
+
+    // the on disk format of the sidecar index, read by queryLog.sh
+    struct IndexEntry {
+        uint64_t offset;
+        // when the line reached the sink, so within a few milliseconds of the logged time
+        int64_t ms;
+        uint8_t severity;
+        uint8_t reserved;
+        uint16_t mod;
+        uint32_t length;
+    };
+    static_assert(sizeof(IndexEntry) == 24);
+    static constexpr uint16_t kNoMod = 0xffff;
+
+    LogSink(std::vector<LogTarget> targets, OverflowPolicy policy = OverflowPolicy::Block);
+    ~LogSink();
+
+    void append(std::string_view data, geode::Severity severity = geode::Severity::Info, geode::Mod* mod = nullptr);
+    // false when the line can't be captured, the caller formats it and appends it instead
+    bool appendDeferred(geode::Severity severity, geode::Mod* mod, fmt::string_view format, fmt::format_args args);
+    // lets callers skip formatting a line that would be dropped anyway
+    bool isAccepting(geode::Severity severity);
+    void flush();
+    // blocks until everything appended before the call has been written, false if the writer took longer than timeout
+    bool flushAndWait(std::chrono::milliseconds timeout = std::chrono::seconds(1));
+
+    // lines waiting for the writer across every lane
+    size_t getQueueDepth() const;
+    size_t getPendingBytes() const;
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        std::atomic<uint64_t> order;
+        uint32_t size;
+        bool deferred;
+        int64_t ms;
+        geode::Mod* mod;
+        std::chrono::steady_clock::time_point queued;
+        std::array<char, kInlineSize> data;
+        std::string overflow;
+    };
+
+    struct Output {
+        LogTarget target;
+        HANDLE handle = INVALID_HANDLE_VALUE;
+        bool closed = false;
+        std::string backlog;
+        size_t written = 0;
+        size_t segment = 0;
+        HANDLE index = INVALID_HANDLE_VALUE;
+    };
+
+    struct Lane {
+        std::unique_ptr<Slot[]> slots;
+        OverflowPolicy policy = OverflowPolicy::Block;
+        alignas(64) std::atomic<size_t> enqueuePos = 0;
+        alignas(64) std::atomic<size_t> dequeuePos = 0;
+        alignas(64) std::atomic<size_t> dropped = 0;
+        // set by a DropOldest producer that found the lane full
+        std::atomic<bool> shed = false;
+    };
+
+    enum class Head {
+        Empty,
+        Pending,
+        Ready
+    };
+
+    static size_t getLaneIndex(geode::Severity severity);
+
+    void push(std::string_view data, geode::Severity severity, geode::Mod* mod, bool deferred);
+    bool tryPush(Lane& lane, std::string_view data, geode::Mod* mod, bool deferred);
+    void take(Lane& lane, size_t pos);
+    void release(Lane& lane, size_t pos, std::string* out);
+    Head peekOrder(Lane& lane, uint64_t& order, size_t& pos);
+    void shed();
+    void appendDropNotices();
+    void run();
+    void connect();
+    bool drain();
+    void write();
+    bool writeAll(HANDLE handle, std::string_view data);
+    void rotate(Output& output);
+    HANDLE openIndex(const Output& output);
+    uint16_t getModIndex(geode::Mod* mod);
+
+    std::array<Lane, kLaneCount> m_lanes;
+    alignas(64) std::atomic<uint64_t> m_nextOrder = 0;
+    alignas(64) std::atomic<size_t> m_pendingBytes = 0;
+
+    std::atomic<bool> m_running = true;
+    std::vector<Output> m_outputs;
+    std::unique_ptr<LogArchiver> m_archiver;
+    HANDLE m_wakeEvent = nullptr;
+    std::string m_batch;
+    // offsets are relative to the start of the batch until it's written
+    std::vector<IndexEntry> m_batchIndex;
+    std::vector<IndexEntry> m_indexOutput;
+    std::unordered_map<geode::Mod*, uint16_t> m_modIndices;
+    HANDLE m_modTable = INVALID_HANDLE_VALUE;
+    bool m_indexed = false;
+    fmt::memory_buffer m_render;
+    std::mutex m_flushMutex;
+    std::condition_variable m_flushed;
+    uint64_t m_flushRequested = 0;
+    uint64_t m_flushCompleted = 0;
+    std::thread m_thread;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <filesystem>
+#include <cstdint>
+
+/*
+    A decimal counter that another process rewrites in place, read through a shared mapping of the file so
+    polling it costs a memory read instead of an open, read and parse through wine.
+*/
+class MappedCounter {
+public:
+    static constexpr size_t kDigits = 20;
+
+    MappedCounter() = default;
+    MappedCounter(const MappedCounter&) = delete;
+    MappedCounter& operator=(const MappedCounter&) = delete;
+
+    ~MappedCounter() {
+        close();
+    }
+
+    bool open(const std::filesystem::path& path) {
+        close();
+
+        m_file = CreateFileW(
+            path.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr
+        );
+        if (m_file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(m_file, &size) || size.QuadPart < static_cast<LONGLONG>(kDigits)) {
+            close();
+            return false;
+        }
+
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_mapping) {
+            close();
+            return false;
+        }
+
+        m_view = static_cast<const volatile char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, kDigits));
+        if (!m_view) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (m_view) UnmapViewOfFile(const_cast<char*>(m_view));
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_view = nullptr;
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+    }
+
+    bool isOpen() const {
+        return m_view != nullptr;
+    }
+
+    /*
+        The writer isn't synchronised with us, so a read can land mid-update. That's fine here, callers only
+        care whether the value moved, and a torn read still differs from the last one.
+    */
+    uint64_t read() const {
+        uint64_t value = 0;
+        for (size_t i = 0; i < kDigits; i++) {
+            char c = m_view[i];
+            if (c < '0' || c > '9') continue;
+            value = value * 10 + (c - '0');
+        }
+        return value;
+    }
+
+private:
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+    const volatile char* m_view = nullptr;
+};
@@ -0,0 +1,202 @@
+#include <Geode/Geode.hpp>
+#include "Metrics.hpp"
+#include "Config.hpp"
+
+using namespace geode::prelude;
+
+Metrics* Metrics::get() {
+    static Metrics instance;
+    return &instance;
+}
+
+size_t Metrics::getShard() {
+    static std::atomic<size_t> next = 0;
+    thread_local size_t shard = next.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return shard;
+}
+
+Metrics::Entry* Metrics::find(std::string_view name, const Labels& labels) {
+    for (auto& entry : m_entries) {
+        if (entry.name == name && entry.labels == labels) return &entry;
+    }
+    return nullptr;
+}
+
+Metrics::Entry& Metrics::add(std::string_view name, std::string_view help, Type type, Labels&& labels) {
+    return m_entries.emplace_back(Entry{std::string(name), std::string(help), type, std::move(labels)});
+}
+
+Metrics::Counter& Metrics::counter(std::string_view name, std::string_view help, Labels labels) {
+    std::lock_guard lock(m_mutex);
+    if (auto entry = find(name, labels); entry && entry->counter) return *entry->counter;
+
+    auto& entry = add(name, help, Type::Counter, std::move(labels));
+    entry.counter = &m_counters.emplace_back();
+    return *entry.counter;
+}
+
+Metrics::Gauge& Metrics::gauge(std::string_view name, std::string_view help, Labels labels) {
+    std::lock_guard lock(m_mutex);
+    if (auto entry = find(name, labels); entry && entry->gauge) return *entry->gauge;
+
+    auto& entry = add(name, help, Type::Gauge, std::move(labels));
+    entry.gauge = &m_gauges.emplace_back();
+    return *entry.gauge;
+}
+
+Metrics::Histogram& Metrics::histogram(std::string_view name, std::string_view help, Labels labels) {
+    std::lock_guard lock(m_mutex);
+    if (auto entry = find(name, labels); entry && entry->histogram) return *entry->histogram;
+
+    auto& entry = add(name, help, Type::Summary, std::move(labels));
+    entry.histogram = &m_histograms.emplace_back();
+    return *entry.histogram;
+}
+
+void Metrics::observe(std::string_view name, std::string_view help, std::function<double()>&& read, Labels labels) {
+    std::lock_guard lock(m_mutex);
+    if (auto entry = find(name, labels)) {
+        entry->read = std::move(read);
+        return;
+    }
+
+    auto& entry = add(name, help, Type::Gauge, std::move(labels));
+    entry.read = std::move(read);
+}
+
+void Metrics::setup() {
+    auto interval = Config::get()->getMetricsInterval();
+    if (interval <= 0) return;
+
+    m_snapshotTimer = Reactor::get()->addTimer(std::chrono::seconds(interval), [this] {
+        snapshot();
+    });
+}
+
+static std::string formatLabels(const Metrics::Labels& labels, std::string_view extra = {}) {
+    if (labels.empty() && extra.empty()) return {};
+
+    std::string out = "{";
+    for (const auto& [key, value] : labels) {
+        if (out.size() > 1) out += ',';
+        out += key;
+        out += "=\"";
+        for (char c : value) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        out += '"';
+    }
+    if (!extra.empty()) {
+        if (out.size() > 1) out += ',';
+        out += extra;
+    }
+    out += '}';
+    return out;
+}
+
+/*
+    Families have to be contiguous in the Prometheus format, entries are sorted by name so labelled metrics
+    registered at different times still end up together.
+*/
+void Metrics::snapshot() {
+    std::vector<Entry> entries;
+    {
+        std::lock_guard lock(m_mutex);
+        entries = m_entries;
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.name < b.name;
+    });
+
+    std::lock_guard lock(m_snapshotMutex);
+
+    std::string prom;
+    auto promOut = std::back_inserter(prom);
+    auto metrics = matjson::Value::array();
+    std::string_view lastName;
+
+    for (const auto& entry : entries) {
+        if (entry.name != lastName) {
+            static constexpr std::array<const char*, 3> types = {"counter", "gauge", "summary"};
+            fmt::format_to(promOut, "# HELP {} {}\n# TYPE {} {}\n", entry.name, entry.help, entry.name, types[static_cast<size_t>(entry.type)]);
+            lastName = entry.name;
+        }
+
+        auto labels = matjson::Value::object();
+        for (const auto& [key, value] : entry.labels) labels.set(key, value);
+
+        auto metric = matjson::Value::object();
+        metric.set("name", entry.name);
+        metric.set("labels", labels);
+
+        if (entry.histogram) {
+            auto& histogram = *entry.histogram;
+            auto p50 = histogram.getPercentile(50) / 1e6;
+            auto p99 = histogram.getPercentile(99) / 1e6;
+            auto sum = histogram.getSum() / 1e6;
+            auto count = histogram.getCount();
+
+            fmt::format_to(promOut, "{}{} {}\n", entry.name, formatLabels(entry.labels, "quantile=\"0.5\""), p50);
+            fmt::format_to(promOut, "{}{} {}\n", entry.name, formatLabels(entry.labels, "quantile=\"0.99\""), p99);
+            fmt::format_to(promOut, "{}_sum{} {}\n", entry.name, formatLabels(entry.labels), sum);
+            fmt::format_to(promOut, "{}_count{} {}\n", entry.name, formatLabels(entry.labels), count);
+            metric.set("count", count);
+            metric.set("sum", sum);
+            metric.set("p50", p50);
+            metric.set("p99", p99);
+            metric.set("max", histogram.getMax() / 1e6);
+        }
+        else {
+            double value = entry.counter ? static_cast<double>(entry.counter->get())
+                : entry.gauge ? entry.gauge->get()
+                : entry.read ? entry.read()
+                : 0.0;
+
+            fmt::format_to(promOut, "{}{} {}\n", entry.name, formatLabels(entry.labels), value);
+            metric.set("value", value);
+        }
+        metrics.push(metric);
+    }
+
+    auto json = matjson::Value::object();
+    json.set("time", std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count());
+    json.set("metrics", metrics);
+
+    writeFile("metrics.prom", prom);
+    writeFile("metrics.json", json.dump());
+}
+
+void Metrics::writeFile(const std::string& name, const std::string& contents) {
+    auto path = Config::get()->getUniquePath() / name;
+    auto temp = Config::get()->getUniquePath() / (name + ".tmp");
+
+    auto res = utils::file::writeString(temp, contents);
+    if (!res) return log::error("Failed to write {}: {}", name, res.unwrapErr());
+
+    if (!MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        log::error("Failed to replace {}: {}", name, GetLastError());
+    }
+}
+
+// logging counts the line in the registry, so nothing is logged until the lock is released
+void Metrics::logSummary() {
+    std::vector<Entry> entries;
+    {
+        std::lock_guard lock(m_mutex);
+        entries = m_entries;
+    }
+
+    for (const auto& entry : entries) {
+        if (!entry.histogram || entry.histogram->getCount() == 0) continue;
+
+        auto& histogram = *entry.histogram;
+        log::info("[metrics] {}{}: p50 {:.2f}ms, p99 {:.2f}ms, max {:.2f}ms ({} samples)",
+            entry.name, formatLabels(entry.labels),
+            histogram.getPercentile(50) / 1000.0, histogram.getPercentile(99) / 1000.0,
+            histogram.getMax() / 1000.0, histogram.getCount()
+        );
+    }
+}
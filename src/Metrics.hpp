@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "LatencyHistogram.hpp"
+#include "Reactor.hpp"
+
+/*
+    Counters, gauges and histograms for watching a long session without attaching anything. Metrics are
+    registered once and held by reference afterwards, so updating one never looks anything up. Counters are
+    sharded per thread so threads logging at the same time don't fight over a cache line.
+
+    The reactor snapshots everything into metrics.prom (Prometheus text) and metrics.json in the session
+    directory. Each file is replaced with a rename, so a reader never sees half of one.
+*/
+class Metrics {
+public:
+    static constexpr size_t kShards = 16;
+
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+    // microseconds, exported in seconds
+    using Histogram = LatencyHistogram;
+
+    class Counter {
+    public:
+        void add(uint64_t value = 1) {
+            m_shards[getShard()].value.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        uint64_t get() const {
+            uint64_t total = 0;
+            for (auto& shard : m_shards) total += shard.value.load(std::memory_order_relaxed);
+            return total;
+        }
+
+    private:
+        struct alignas(64) Shard {
+            std::atomic<uint64_t> value = 0;
+        };
+
+        std::array<Shard, kShards> m_shards;
+    };
+
+    class Gauge {
+    public:
+        void set(double value) {
+            m_value.store(value, std::memory_order_relaxed);
+        }
+
+        double get() const {
+            return m_value.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<double> m_value = 0;
+    };
+
+    static Metrics* get();
+
+    // registering the same name and labels twice hands back the same metric
+    Counter& counter(std::string_view name, std::string_view help, Labels labels = {});
+    Gauge& gauge(std::string_view name, std::string_view help, Labels labels = {});
+    Histogram& histogram(std::string_view name, std::string_view help, Labels labels = {});
+    // read on the reactor thread at every snapshot
+    void observe(std::string_view name, std::string_view help, std::function<double()>&& read, Labels labels = {});
+
+    void setup();
+    void snapshot();
+    // histogram percentiles into the log, for the end of a session
+    void logSummary();
+
+private:
+    enum class Type {
+        Counter,
+        Gauge,
+        Summary
+    };
+
+    struct Entry {
+        std::string name;
+        std::string help;
+        Type type;
+        Labels labels;
+        Counter* counter = nullptr;
+        Gauge* gauge = nullptr;
+        Histogram* histogram = nullptr;
+        std::function<double()> read;
+    };
+
+    static size_t getShard();
+
+    Entry* find(std::string_view name, const Labels& labels);
+    Entry& add(std::string_view name, std::string_view help, Type type, Labels&& labels);
+    void writeFile(const std::string& name, const std::string& contents);
+
+    std::mutex m_mutex;
+    std::vector<Entry> m_entries;
+    std::deque<Counter> m_counters;
+    std::deque<Gauge> m_gauges;
+    std::deque<Histogram> m_histograms;
+
+    std::mutex m_snapshotMutex;
+    Reactor::Id m_snapshotTimer = 0;
+};
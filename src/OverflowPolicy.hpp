@@ -0,0 +1,12 @@
+#pragma once
+
+// what a LogSink lane does when a line arrives and it's full
+enum class OverflowPolicy {
+    // wait for the writer to make room
+    Block,
+    // have the writer cut the oldest half of the lane and retry, the new line is only lost if that takes
+    // longer than LogSink::kShedWait
+    DropOldest,
+    // throw away the new line
+    DropNewest
+};
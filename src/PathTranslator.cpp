@@ -0,0 +1,294 @@
+#include <Geode/Geode.hpp>
+#include "PathTranslator.hpp"
+#include "Config.hpp"
+#include "Utils.hpp"
+
+using namespace geode::prelude;
+
+PathTranslator* PathTranslator::get() {
+    static PathTranslator instance;
+    return &instance;
+}
+
+/*
+    wine_get_unix_file_name gives us C:'s entry in dosdevices, which tells us where the prefix really is
+    without trusting WINEPREFIX. Until the symlinks are resolved every drive maps to its dosdevices entry,
+    which is a valid linux path, just not the one a picker would hand back.
+*/
+PathTranslator::PathTranslator() {
+    using WineGetUnixFileName = char* (CDECL*)(LPCWSTR);
+
+    HMODULE kernel32 = GetModuleHandleA("kernel32.dll");
+    auto getUnixFileName = kernel32
+        ? reinterpret_cast<WineGetUnixFileName>(GetProcAddress(kernel32, "wine_get_unix_file_name"))
+        : nullptr;
+
+    if (getUnixFileName) {
+        if (char* unixPath = getUnixFileName(L"C:\\")) {
+            std::string_view drive = unixPath;
+            while (!drive.empty() && drive.back() == '/') drive.remove_suffix(1);
+            m_dosdevices = drive.substr(0, drive.rfind('/'));
+            HeapFree(GetProcessHeap(), 0, unixPath);
+        }
+    }
+
+    if (m_dosdevices.empty()) {
+        const char* prefixEnv = std::getenv("WINEPREFIX");
+        const char* homeEnv = std::getenv("HOME");
+
+        if (prefixEnv) m_dosdevices = prefixEnv;
+        else if (homeEnv) m_dosdevices = std::string(homeEnv) + "/.wine";
+        else m_dosdevices = "/.wine";
+        m_dosdevices += "/dosdevices";
+    }
+
+    auto table = std::make_shared<Table>();
+    DWORD drives = GetLogicalDrives();
+    for (int i = 0; i < 26; i++) {
+        table->roots[i] = fmt::format("{}/{}:", m_dosdevices, static_cast<char>('a' + i));
+        if (drives & (1u << i)) table->add(i, table->roots[i], true);
+    }
+    m_table = std::move(table);
+}
+
+// blocks on the helper script, called from the startup thread
+void PathTranslator::setup() {
+    auto path = setupScript();
+    if (path.empty()) return;
+
+    auto outputRes = sobriety::utils::runCommandForOutput(
+        fmt::format("{} \"{}\"", utils::string::pathToString(path), m_dosdevices)
+    );
+    if (!outputRes) return log::error("Failed to resolve wine drives: {}", outputRes.unwrapErr());
+    applyResolved(outputRes.unwrap());
+}
+
+std::filesystem::path PathTranslator::setupScript() {
+    static std::string script =
+R"script(#!/bin/bash
+
+# Prints "<letter> <target>" for each drive so the game can map paths the way the kernel sees them
+DOSDEVICES="$1"
+
+for DEVICE in "$DOSDEVICES"/?:; do
+    [ -e "$DEVICE" ] || continue
+    LETTER="${DEVICE: -2:1}"
+    printf '%s\t%s\n' "${LETTER,,}" "$(readlink -f "$DEVICE")"
+done
+
+)script";
+
+    auto res = sobriety::utils::emitScript("resolveDrives", script);
+    if (!res) {
+        log::error("Failed to create resolveDrives script: {}", res.unwrapErr());
+        return {};
+    }
+    return res.unwrap();
+}
+
+/*
+    Resolved targets become the forward mapping, the dosdevices entries stay in the trie so paths either way
+    still map back. A resolved root wins over an alias of the same length, so z: on / isn't shadowed.
+*/
+void PathTranslator::applyResolved(const std::string& output) {
+    auto current = getTable();
+    auto table = std::make_shared<Table>();
+    table->roots = current->roots;
+
+    std::array<bool, 26> resolved{};
+    for (auto& line : utils::string::split(output, "\n")) {
+        auto tab = line.find('\t');
+        if (tab != 1 || line[0] < 'a' || line[0] > 'z' || line.size() <= 2 || line[2] != '/') continue;
+
+        int drive = line[0] - 'a';
+        std::string_view root = std::string_view(line).substr(2);
+        while (!root.empty() && root.back() == '/') root.remove_suffix(1);
+
+        table->roots[drive] = root;
+        table->add(drive, root, true);
+        resolved[drive] = true;
+    }
+
+    for (int i = 0; i < 26; i++) {
+        if (current->present[i]) table->add(i, current->roots[i], !resolved[i]);
+    }
+
+    std::lock_guard lock(m_mutex);
+    m_table = std::move(table);
+    m_linuxCache.clear();
+    m_wineCache.clear();
+}
+
+void PathTranslator::Table::add(int drive, std::string_view root, bool primary) {
+    present[drive] = true;
+
+    auto node = &reverse;
+    for (auto& part : utils::string::split(std::string(root), "/")) {
+        if (part.empty()) continue;
+        auto& child = node->children[part];
+        if (!child) child = std::make_unique<TrieNode>();
+        node = child.get();
+    }
+    if (node->drive < 0 || primary) node->drive = drive;
+}
+
+std::shared_ptr<const PathTranslator::Table> PathTranslator::getTable() {
+    std::lock_guard lock(m_mutex);
+    return m_table;
+}
+
+std::string PathTranslator::toLinux(const std::filesystem::path& winPath) {
+    std::string key = utils::string::pathToString(winPath);
+
+    std::lock_guard lock(m_mutex);
+    std::string result;
+    if (m_linuxCache.get(key, result)) return result;
+
+    result = translateToLinux(*m_table, key);
+    m_linuxCache.put(key, result);
+    return result;
+}
+
+std::filesystem::path PathTranslator::toWine(std::string_view linuxPath) {
+    std::string key(linuxPath);
+
+    std::lock_guard lock(m_mutex);
+    std::filesystem::path result;
+    if (m_wineCache.get(key, result)) return result;
+
+    result = translateToWine(*m_table, key);
+    m_wineCache.put(key, result);
+    return result;
+}
+
+// batches skip the cache, a few thousand picked files would only evict the paths worth keeping
+std::vector<std::string> PathTranslator::toLinux(const std::vector<std::filesystem::path>& winPaths) {
+    auto table = getTable();
+
+    std::vector<std::string> results;
+    results.reserve(winPaths.size());
+    for (auto& path : winPaths) {
+        results.push_back(translateToLinux(*table, utils::string::pathToString(path)));
+    }
+    return results;
+}
+
+std::vector<std::filesystem::path> PathTranslator::toWine(const std::vector<std::string>& linuxPaths) {
+    auto table = getTable();
+
+    std::vector<std::filesystem::path> results;
+    results.reserve(linuxPaths.size());
+    for (auto& path : linuxPaths) {
+        if (!path.empty()) results.push_back(translateToWine(*table, path));
+    }
+    return results;
+}
+
+/*
+    Still built as a string, wine would turn a std::filesystem::path straight back into the windows path.
+    The result is sized up front and separators are collapsed in place, so it's the only allocation.
+*/
+std::string PathTranslator::translateToLinux(const Table& table, std::string_view winPath) {
+    if (winPath.size() < 2 || winPath[1] != ':') return std::string(winPath);
+
+    int drive = std::tolower(static_cast<unsigned char>(winPath[0])) - 'a';
+    if (drive < 0 || drive >= 26) return std::string(winPath);
+
+    auto& root = table.roots[drive];
+    auto rest = winPath.substr(2);
+
+    std::string result;
+    result.reserve(root.size() + rest.size() + 1);
+    result += root;
+
+    bool separator = true;
+    for (char c : rest) {
+        if (c == '\\' || c == '/') {
+            separator = true;
+            continue;
+        }
+        if (separator) result += '/';
+        separator = false;
+        result += c;
+    }
+    if (result.empty()) result += '/';
+
+    return result;
+}
+
+std::filesystem::path PathTranslator::translateToWine(const Table& table, std::string_view linuxPath) {
+    if (linuxPath.empty() || linuxPath[0] != '/') return std::filesystem::path(utils::string::utf8ToWide(linuxPath));
+
+    int drive = table.reverse.drive;
+    size_t matched = 0;
+
+    auto node = &table.reverse;
+    size_t pos = 0;
+    while (pos < linuxPath.size()) {
+        while (pos < linuxPath.size() && linuxPath[pos] == '/') pos++;
+        if (pos >= linuxPath.size()) break;
+
+        size_t end = linuxPath.find('/', pos);
+        if (end == std::string_view::npos) end = linuxPath.size();
+
+        auto it = node->children.find(linuxPath.substr(pos, end - pos));
+        if (it == node->children.end()) break;
+
+        node = it->second.get();
+        if (node->drive >= 0) {
+            drive = node->drive;
+            matched = end;
+        }
+        pos = end;
+    }
+
+    if (drive < 0) return std::filesystem::path(utils::string::utf8ToWide(linuxPath));
+
+    auto rest = linuxPath.substr(matched);
+    int restSize = rest.empty() ? 0 : MultiByteToWideChar(CP_UTF8, 0, rest.data(), static_cast<int>(rest.size()), nullptr, 0);
+
+    std::wstring result(2 + std::max(restSize, 1), L'\\');
+    result[0] = static_cast<wchar_t>(L'A' + drive);
+    result[1] = L':';
+    if (restSize > 0) {
+        MultiByteToWideChar(CP_UTF8, 0, rest.data(), static_cast<int>(rest.size()), result.data() + 2, restSize);
+    }
+
+    size_t out = 2;
+    for (size_t i = 2; i < result.size(); i++) {
+        wchar_t c = result[i] == L'/' ? L'\\' : result[i];
+        if (c == L'\\' && out > 2 && result[out - 1] == L'\\') continue;
+        result[out++] = c;
+    }
+    result.resize(std::max<size_t>(out, 3));
+
+    return std::filesystem::path(std::move(result));
+}
+
+template <class V>
+bool PathTranslator::LruCache<V>::get(const std::string& key, V& out) {
+    auto it = m_index.find(key);
+    if (it == m_index.end()) return false;
+
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    out = it->second->second;
+    return true;
+}
+
+template <class V>
+void PathTranslator::LruCache<V>::put(const std::string& key, const V& value) {
+    if (m_index.contains(key)) return;
+
+    if (m_entries.size() >= kCacheSize) {
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+    m_entries.emplace_front(key, value);
+    m_index.emplace(key, m_entries.begin());
+}
+
+template <class V>
+void PathTranslator::LruCache<V>::clear() {
+    m_entries.clear();
+    m_index.clear();
+}
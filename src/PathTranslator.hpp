@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+    Converts between wine and linux paths using the prefix's actual drive table instead of assuming
+    drive_<letter> and Z: = /. Drive roots come from wine itself, then get swapped for their resolved
+    dosdevices symlink targets once a helper script has read them, since those are what native pickers return.
+*/
+class PathTranslator {
+public:
+    static constexpr size_t kCacheSize = 512;
+
+    static PathTranslator* get();
+
+    void setup();
+    std::filesystem::path setupScript();
+
+    std::string toLinux(const std::filesystem::path& winPath);
+    std::filesystem::path toWine(std::string_view linuxPath);
+
+    std::vector<std::string> toLinux(const std::vector<std::filesystem::path>& winPaths);
+    std::vector<std::filesystem::path> toWine(const std::vector<std::string>& linuxPaths);
+
+private:
+    struct ComponentHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view part) const {
+            return std::hash<std::string_view>{}(part);
+        }
+    };
+
+    struct TrieNode {
+        std::unordered_map<std::string, std::unique_ptr<TrieNode>, ComponentHash, std::equal_to<>> children;
+        int drive = -1;
+    };
+
+    struct Table {
+        // linux root of each drive without a trailing slash, so "/" is stored as ""
+        std::array<std::string, 26> roots;
+        std::array<bool, 26> present{};
+        TrieNode reverse;
+
+        void add(int drive, std::string_view root, bool primary);
+    };
+
+    template <class V>
+    class LruCache {
+    public:
+        bool get(const std::string& key, V& out);
+        void put(const std::string& key, const V& value);
+        void clear();
+
+    private:
+        std::list<std::pair<std::string, V>> m_entries;
+        std::unordered_map<std::string, typename std::list<std::pair<std::string, V>>::iterator> m_index;
+    };
+
+    PathTranslator();
+
+    std::shared_ptr<const Table> getTable();
+    std::string translateToLinux(const Table& table, std::string_view winPath);
+    std::filesystem::path translateToWine(const Table& table, std::string_view linuxPath);
+    void applyResolved(const std::string& output);
+
+    std::mutex m_mutex;
+    std::shared_ptr<const Table> m_table;
+    std::string m_dosdevices;
+    LruCache<std::string> m_linuxCache;
+    LruCache<std::filesystem::path> m_wineCache;
+};
@@ -0,0 +1,45 @@
+#include <Geode/Geode.hpp>
+#include "FileExplorer.hpp"
+#include "PathTranslator.hpp"
+
+using namespace geode::prelude;
+
+/*
+    The picker script's side of the protocol, what it's given for filters and how its answer is read back.
+    Kept apart from the rest of FileExplorer since neither touches cocos or wine, which lets the native
+    benchmark build them.
+*/
+
+std::vector<std::string> FileExplorer::generateExtensionStrings(std::vector<utils::file::FilePickOptions::Filter> filters) {
+    std::vector<std::string> strings;
+
+    filters.push_back({"All Files", {"*.*"}});
+
+    for (const auto& filter : filters) {
+        std::string extStr = utils::string::trim(filter.description);
+        extStr += "|";
+        for (const auto& extension : filter.files) {
+            extStr += utils::string::trim(extension);
+            extStr += " ";
+        }
+        strings.push_back(utils::string::trim(extStr));
+    }
+    return strings;
+}
+
+std::optional<PickSelection> FileExplorer::parseSelection(std::string str) {
+    utils::string::trimIP(str);
+
+    if (str.empty()) return std::nullopt;
+
+    PickSelection selection;
+    if (str == "-1") {
+        selection.cancelled = true;
+        return selection;
+    }
+
+    // pickers answer with linux paths, the game expects drive letters back
+    selection.paths = PathTranslator::get()->toWine(utils::string::split(str, "\n"));
+    selection.text = std::move(str);
+    return selection;
+}
@@ -0,0 +1,256 @@
+#include <Geode/Geode.hpp>
+#include "Profiler.hpp"
+#include "Config.hpp"
+#include "Metrics.hpp"
+
+using namespace geode::prelude;
+
+Profiler* Profiler::get() {
+    static Profiler instance;
+    return &instance;
+}
+
+size_t Profiler::StackHash::operator()(const std::vector<uint64_t>& frames) const {
+    size_t hash = frames.size();
+    for (auto frame : frames) hash ^= std::hash<uint64_t>{}(frame) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+void Profiler::setup() {
+    if (!Config::get()->shouldProfile()) return;
+
+    m_interval = std::chrono::microseconds(1'000'000 / std::max(Config::get()->getProfilerRate(), 1));
+    queueInMainThread([this] {
+        start();
+    });
+}
+
+// on the main thread, for its handle and stack
+void Profiler::start() {
+    auto access = THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION;
+    if (!DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &m_mainThread, access, FALSE, 0)) {
+        return log::error("Failed to open the main thread for profiling: {}", GetLastError());
+    }
+
+    ULONG_PTR low = 0;
+    ULONG_PTR high = 0;
+    GetCurrentThreadStackLimits(&low, &high);
+    m_stackBase = high;
+    m_stackCopySize = high - low;
+    m_stackCopy = std::make_unique<uint8_t[]>(m_stackCopySize);
+
+    m_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    m_running.store(true, std::memory_order_relaxed);
+    m_thread = std::thread([this] {
+        thread::setName("Sobriety Profiler");
+        run();
+    });
+
+    log::info("Profiling the main thread every {}us", m_interval.count());
+}
+
+void Profiler::stop() {
+    if (!m_running.exchange(false, std::memory_order_relaxed)) return;
+    SetEvent(m_stopEvent);
+    m_thread.join();
+    CloseHandle(m_stopEvent);
+    CloseHandle(m_mainThread);
+
+    auto elapsed = std::chrono::steady_clock::now() - m_started;
+    log::info("Profiler took {} samples ({} failed), the main thread spent {:.2f}ms paused, {:.3f}% of the time profiled",
+        m_samples, m_failures,
+        std::chrono::duration<double, std::milli>(m_paused).count(),
+        elapsed.count() > 0 ? 100.0 * m_paused / elapsed : 0.0
+    );
+}
+
+void Profiler::run() {
+    static auto& samples = Metrics::get()->counter("sobriety_profiler_samples_total", "Main thread stacks sampled by the profiler", {{"result", "ok"}});
+    static auto& failures = Metrics::get()->counter("sobriety_profiler_samples_total", "Main thread stacks sampled by the profiler", {{"result", "failed"}});
+    static auto& overhead = Metrics::get()->gauge("sobriety_profiler_overhead_ratio", "Share of the main thread's time spent paused by the profiler");
+
+    m_started = std::chrono::steady_clock::now();
+    auto lastWrite = m_started;
+    auto interval = m_interval;
+    Stack stack;
+
+    while (WaitForSingleObject(m_stopEvent, static_cast<DWORD>(std::max<int64_t>(interval.count() / 1000, 1))) == WAIT_TIMEOUT) {
+        stack.depth = 0;
+        if (sample(stack)) {
+            m_samples++;
+            samples.add();
+            m_stacks[std::vector<uint64_t>(stack.frames.begin(), stack.frames.begin() + stack.depth)]++;
+        }
+        else {
+            m_failures++;
+            failures.add();
+        }
+
+        // sample less often rather than let pausing take more than its share
+        auto now = std::chrono::steady_clock::now();
+        auto average = m_paused / (m_samples + m_failures);
+        interval = std::max(m_interval, std::chrono::duration_cast<std::chrono::microseconds>(average / kMaxOverhead));
+        overhead.set(static_cast<double>(m_paused.count()) / std::max<int64_t>((now - m_started).count(), 1));
+
+        if (now - lastWrite >= kWriteInterval) {
+            write();
+            lastWrite = now;
+        }
+    }
+    write();
+}
+
+/*
+    Nothing between SuspendThread and ResumeThread may allocate, log or take a lock.
+*/
+bool Profiler::sample(Stack& stack) {
+    static auto& pause = Metrics::get()->histogram("sobriety_profiler_pause_seconds", "How long the main thread is held suspended for each sample");
+
+    CONTEXT context{};
+    context.ContextFlags = CONTEXT_FULL;
+    size_t size = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    if (SuspendThread(m_mainThread) == static_cast<DWORD>(-1)) return false;
+
+    bool copied = GetThreadContext(m_mainThread, &context);
+    auto stackPointer = static_cast<uintptr_t>(context.Rsp);
+    if (copied && stackPointer < m_stackBase && m_stackBase - stackPointer <= m_stackCopySize) {
+        size = m_stackBase - stackPointer;
+        std::memcpy(m_stackCopy.get(), reinterpret_cast<const void*>(stackPointer), size);
+    }
+    else {
+        copied = false;
+    }
+
+    ResumeThread(m_mainThread);
+    auto paused = std::chrono::steady_clock::now() - start;
+    m_paused += paused;
+    pause.record(paused);
+
+    if (!copied) return false;
+    unwind(context, stackPointer, size, stack);
+    return stack.depth > 0;
+}
+
+/*
+    Anything in the registers or on the stack that points into the original stack is moved to point into the
+    copy, then the copy is unwound with the unwind data in each module's .pdata. A function without unwind
+    data is a leaf, its return address is right at the stack pointer.
+
+    Frames are recorded by the start of their function so samples anywhere in one land on the same frame.
+*/
+void Profiler::unwind(CONTEXT& context, uintptr_t original, size_t size, Stack& stack) {
+    auto copy = reinterpret_cast<uintptr_t>(m_stackCopy.get());
+    auto end = copy + size;
+    auto relocate = [&](DWORD64& value) {
+        if (value >= original && value < original + size) value = value - original + copy;
+    };
+
+    for (auto reg : {
+        &context.Rax, &context.Rbx, &context.Rcx, &context.Rdx, &context.Rsi, &context.Rdi, &context.Rbp, &context.Rsp,
+        &context.R8, &context.R9, &context.R10, &context.R11, &context.R12, &context.R13, &context.R14, &context.R15
+    }) {
+        relocate(*reg);
+    }
+    for (size_t offset = 0; offset + sizeof(DWORD64) <= size; offset += sizeof(DWORD64)) {
+        relocate(*reinterpret_cast<DWORD64*>(copy + offset));
+    }
+
+    while (stack.depth < kMaxDepth) {
+        DWORD64 imageBase = 0;
+        auto function = RtlLookupFunctionEntry(context.Rip, &imageBase, nullptr);
+        stack.frames[stack.depth++] = function ? imageBase + function->BeginAddress : context.Rip;
+
+        if (function) {
+            void* handlerData = nullptr;
+            DWORD64 establisherFrame = 0;
+            RtlVirtualUnwind(UNW_FLAG_NHANDLER, imageBase, context.Rip, function, &context, &handlerData, &establisherFrame, nullptr);
+        }
+        else {
+            if (context.Rsp < copy || context.Rsp + sizeof(DWORD64) > end) break;
+            context.Rip = *reinterpret_cast<DWORD64*>(context.Rsp);
+            context.Rsp += sizeof(DWORD64);
+        }
+
+        if (context.Rip == 0 || context.Rsp < copy || context.Rsp >= end) break;
+    }
+}
+
+const std::string& Profiler::getFrameName(uint64_t address) {
+    auto iter = m_frameNames.find(address);
+    if (iter != m_frameNames.end()) return iter->second;
+
+    HMODULE handle = nullptr;
+    auto flags = GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT;
+    std::string name;
+    if (GetModuleHandleExW(flags, reinterpret_cast<LPCWSTR>(address), &handle)) {
+        auto& module = getModule(handle);
+        auto rva = static_cast<DWORD>(address - reinterpret_cast<uintptr_t>(handle));
+        auto exported = module.exports.find(rva);
+        name = exported != module.exports.end()
+            ? fmt::format("{}!{}", module.name, exported->second)
+            : fmt::format("{}+0x{:x}", module.name, rva);
+    }
+    else {
+        name = fmt::format("0x{:x}", address);
+    }
+
+    return m_frameNames.emplace(address, std::move(name)).first->second;
+}
+
+// exported names come straight from the export directory of the loaded image
+const Profiler::Module& Profiler::getModule(HMODULE handle) {
+    auto iter = m_modules.find(handle);
+    if (iter != m_modules.end()) return iter->second;
+
+    Module module;
+    std::array<wchar_t, MAX_PATH> path{};
+    auto length = GetModuleFileNameW(handle, path.data(), static_cast<DWORD>(path.size()));
+    module.name = length > 0
+        ? utils::string::pathToString(std::filesystem::path(std::wstring(path.data(), length)).filename())
+        : fmt::format("0x{:x}", reinterpret_cast<uintptr_t>(handle));
+
+    auto base = reinterpret_cast<const uint8_t*>(handle);
+    auto dos = reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
+    auto nt = reinterpret_cast<const IMAGE_NT_HEADERS*>(base + dos->e_lfanew);
+    auto& directory = nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
+
+    if (directory.VirtualAddress != 0 && directory.Size != 0) {
+        auto exports = reinterpret_cast<const IMAGE_EXPORT_DIRECTORY*>(base + directory.VirtualAddress);
+        auto names = reinterpret_cast<const DWORD*>(base + exports->AddressOfNames);
+        auto ordinals = reinterpret_cast<const WORD*>(base + exports->AddressOfNameOrdinals);
+        auto functions = reinterpret_cast<const DWORD*>(base + exports->AddressOfFunctions);
+
+        for (DWORD i = 0; i < exports->NumberOfNames; i++) {
+            // the folded format splits on semicolons and the last space
+            std::string name = reinterpret_cast<const char*>(base + names[i]);
+            std::replace(name.begin(), name.end(), ';', '_');
+            std::replace(name.begin(), name.end(), ' ', '_');
+            module.exports.emplace(functions[ordinals[i]], std::move(name));
+        }
+    }
+
+    return m_modules.emplace(handle, std::move(module)).first->second;
+}
+
+void Profiler::write() {
+    std::string folded;
+    for (const auto& [frames, count] : m_stacks) {
+        for (auto frame = frames.rbegin(); frame != frames.rend(); ++frame) {
+            if (frame != frames.rbegin()) folded += ';';
+            folded += getFrameName(*frame);
+        }
+        fmt::format_to(std::back_inserter(folded), " {}\n", count);
+    }
+
+    auto path = Config::get()->getUniquePath() / "profile.folded";
+    auto temp = Config::get()->getUniquePath() / "profile.folded.tmp";
+
+    auto res = utils::file::writeString(temp, folded);
+    if (!res) return log::error("Failed to write profile: {}", res.unwrapErr());
+
+    if (!MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        log::error("Failed to replace profile: {}", GetLastError());
+    }
+}
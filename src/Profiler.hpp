@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/*
+    Samples the main thread's stack and writes profile.folded (one "outer;...;inner count" line per stack, what
+    flamegraph.pl and speedscope read) into the session directory. Off unless profiler-enabled is set.
+
+    While the main thread is suspended it could be holding any lock, the heap's or the loader's included, so
+    the sampler only copies its registers and stack into buffers allocated up front and resumes it. Unwinding
+    and looking up modules happen on the copy afterwards. That's also why it has its own thread instead of a
+    reactor timer, a sample that goes wrong can only ever stall the profiler.
+
+    Frames are named module!export when the function is exported and module+0xoffset otherwise, which is
+    enough to tell which mod the time went to and to look the rest up against a map file or the bindings.
+    Time spent with the main thread paused is measured, and the rate is lowered whenever it would cost more
+    than kMaxOverhead of the main thread's time.
+*/
+class Profiler {
+public:
+    static constexpr size_t kMaxDepth = 128;
+    static constexpr double kMaxOverhead = 0.02;
+    static constexpr auto kWriteInterval = std::chrono::seconds(10);
+
+    static Profiler* get();
+
+    void setup();
+    // writes the profile one last time
+    void stop();
+
+private:
+    struct Stack {
+        std::array<uint64_t, kMaxDepth> frames;
+        size_t depth = 0;
+    };
+
+    struct StackHash {
+        size_t operator()(const std::vector<uint64_t>& frames) const;
+    };
+
+    struct Module {
+        std::string name;
+        // export rva to name
+        std::unordered_map<DWORD, std::string> exports;
+    };
+
+    void start();
+    void run();
+    bool sample(Stack& stack);
+    void unwind(CONTEXT& context, uintptr_t original, size_t size, Stack& stack);
+    const std::string& getFrameName(uint64_t address);
+    const Module& getModule(HMODULE handle);
+    void write();
+
+    HANDLE m_mainThread = nullptr;
+    uintptr_t m_stackBase = 0;
+    std::unique_ptr<uint8_t[]> m_stackCopy;
+    size_t m_stackCopySize = 0;
+
+    std::chrono::microseconds m_interval{};
+    HANDLE m_stopEvent = nullptr;
+    std::atomic<bool> m_running = false;
+    std::thread m_thread;
+
+    // sampler thread only
+    std::unordered_map<std::vector<uint64_t>, uint64_t, StackHash> m_stacks;
+    std::unordered_map<uint64_t, std::string> m_frameNames;
+    std::unordered_map<HMODULE, Module> m_modules;
+    uint64_t m_samples = 0;
+    uint64_t m_failures = 0;
+    std::chrono::steady_clock::duration m_paused{};
+    std::chrono::steady_clock::time_point m_started;
+};
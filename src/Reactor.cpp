@@ -0,0 +1,142 @@
+#include <Geode/Geode.hpp>
+#include "Reactor.hpp"
+
+using namespace geode::prelude;
+
+Reactor* Reactor::get() {
+    static Reactor instance;
+    return &instance;
+}
+
+Reactor::Reactor() {
+    m_wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    m_thread = std::thread([this] {
+        thread::setName("Sobriety Reactor");
+        m_threadId = GetCurrentThreadId();
+        run();
+    });
+}
+
+Reactor::~Reactor() {
+    m_stop = true;
+    SetEvent(m_wakeEvent);
+    if (m_thread.joinable()) m_thread.join();
+    CloseHandle(m_wakeEvent);
+}
+
+bool Reactor::isReactorThread() const {
+    return GetCurrentThreadId() == m_threadId;
+}
+
+Reactor::Id Reactor::watchHandle(HANDLE handle, std::function<void()>&& method, bool once) {
+    Entry entry;
+    entry.handle = handle;
+    entry.once = once;
+    entry.method = std::make_shared<std::function<void()>>(std::move(method));
+    return add(std::move(entry));
+}
+
+Reactor::Id Reactor::addTimer(std::chrono::milliseconds interval, std::function<void()>&& method) {
+    Entry entry;
+    entry.interval = std::max(interval, std::chrono::milliseconds(1));
+    entry.due = Clock::now() + entry.interval;
+    entry.method = std::make_shared<std::function<void()>>(std::move(method));
+    return add(std::move(entry));
+}
+
+Reactor::Id Reactor::add(Entry&& entry) {
+    Id id;
+    {
+        std::lock_guard lock(m_mutex);
+        id = m_nextId++;
+        m_entries.emplace(id, std::move(entry));
+    }
+    SetEvent(m_wakeEvent);
+    return id;
+}
+
+void Reactor::remove(Id id) {
+    {
+        std::unique_lock lock(m_mutex);
+        m_entries.erase(id);
+        if (!isReactorThread()) {
+            m_idle.wait(lock, [this, id] { return m_runningId != id; });
+        }
+    }
+    SetEvent(m_wakeEvent);
+}
+
+void Reactor::run() {
+    std::vector<HANDLE> handles;
+    std::vector<Id> ids;
+    std::vector<Id> dueTimers;
+
+    while (!m_stop) {
+        handles.assign(1, m_wakeEvent);
+        ids.assign(1, 0);
+        DWORD timeout = INFINITE;
+        {
+            std::lock_guard lock(m_mutex);
+            auto now = Clock::now();
+            for (const auto& [id, entry] : m_entries) {
+                if (entry.handle) {
+                    if (handles.size() == MAXIMUM_WAIT_OBJECTS) continue;
+                    handles.push_back(entry.handle);
+                    ids.push_back(id);
+                }
+                else {
+                    auto wait = std::chrono::ceil<std::chrono::milliseconds>(entry.due - now).count();
+                    timeout = std::min<DWORD>(timeout, static_cast<DWORD>(std::max<long long>(wait, 0)));
+                }
+            }
+        }
+
+        DWORD res = WaitForMultipleObjectsEx(static_cast<DWORD>(handles.size()), handles.data(), FALSE, timeout, TRUE);
+        if (m_stop) break;
+
+        if (res > WAIT_OBJECT_0 && res < WAIT_OBJECT_0 + handles.size()) {
+            fire(ids[res - WAIT_OBJECT_0]);
+        }
+
+        dueTimers.clear();
+        {
+            std::lock_guard lock(m_mutex);
+            auto now = Clock::now();
+            for (const auto& [id, entry] : m_entries) {
+                if (!entry.handle && entry.due <= now) dueTimers.push_back(id);
+            }
+        }
+        for (auto id : dueTimers) fire(id);
+    }
+}
+
+void Reactor::fire(Id id) {
+    std::shared_ptr<std::function<void()>> method;
+    {
+        std::lock_guard lock(m_mutex);
+        auto iter = m_entries.find(id);
+        if (iter == m_entries.end()) return;
+
+        auto& entry = iter->second;
+        method = entry.method;
+
+        if (entry.once) {
+            m_entries.erase(iter);
+        }
+        else if (!entry.handle) {
+            // stay on the original grid, but don't fire a backlog of ticks after a stall
+            entry.due += entry.interval;
+            auto now = Clock::now();
+            if (entry.due <= now) entry.due = now + entry.interval;
+        }
+        m_runningId = id;
+    }
+
+    if (*method) (*method)();
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_runningId = 0;
+    }
+    m_idle.notify_all();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/*
+    One background thread that waits on every handle and timer the mod cares about, so watching another
+    directory or helper process doesn't cost another thread. Callbacks run on the reactor thread and should
+    hand anything slow or main thread only off elsewhere.
+*/
+class Reactor {
+public:
+    using Id = uint64_t;
+    using Clock = std::chrono::steady_clock;
+
+    static Reactor* get();
+
+    Reactor();
+    ~Reactor();
+
+    // once is for handles that stay signaled, like processes, otherwise the callback must reset the handle
+    Id watchHandle(HANDLE handle, std::function<void()>&& method, bool once = false);
+    Id addTimer(std::chrono::milliseconds interval, std::function<void()>&& method);
+    // when called off the reactor thread, waits for a running callback with this id to return
+    void remove(Id id);
+
+    bool isReactorThread() const;
+
+private:
+    struct Entry {
+        HANDLE handle = nullptr;
+        bool once = false;
+        std::chrono::milliseconds interval{};
+        Clock::time_point due;
+        std::shared_ptr<std::function<void()>> method;
+    };
+
+    Id add(Entry&& entry);
+    void run();
+    void fire(Id id);
+
+    std::mutex m_mutex;
+    std::condition_variable m_idle;
+    std::map<Id, Entry> m_entries;
+    Id m_nextId = 1;
+    Id m_runningId = 0;
+
+    HANDLE m_wakeEvent = nullptr;
+    std::atomic<bool> m_stop = false;
+    std::atomic<DWORD> m_threadId = 0;
+    std::thread m_thread;
+};
@@ -1,10 +1,16 @@
 #include <Geode/Geode.hpp>
 #include "Scheduler.hpp"
+#include "Tracer.hpp"
 
 using namespace geode::prelude;
 
+// kept alive for good, nothing else holds on to it while it's unscheduled
 Scheduler* Scheduler::get() {
-    static Scheduler* instance = Scheduler::create();
+    static Scheduler* instance = [] {
+        auto scheduler = Scheduler::create();
+        scheduler->retain();
+        return scheduler;
+    }();
     return instance;
 }
 
@@ -19,20 +25,121 @@ Scheduler* Scheduler::create() {
     return nullptr;
 }
 
-void Scheduler::unschedule(const std::string& id) {
-    m_scheduledMethods.erase(id);
+Scheduler::Handle Scheduler::add(SmallFunction<>&& method, Clock::duration interval, Overrun overrun) {
+    auto handle = m_nextHandle++;
+    auto due = Clock::now() + interval;
+
+    m_scheduledMethods.emplace(handle, ScheduledMethod{std::move(method), interval, due, overrun});
+    push(handle, due);
+    setActive(true);
+
+    return handle;
 }
 
-void Scheduler::update(float dt) {
-    for (auto& [k, v] : m_scheduledMethods) {
-        v.elapsedTime += dt * 1000;
-        if (v.elapsedTime >= v.interval) {
-            if (v.method) v.method();
-            v.elapsedTime -= v.interval;
-        }
+void Scheduler::unschedule(Handle handle) {
+    m_scheduledMethods.erase(handle);
+    if (m_scheduledMethods.empty()) {
+        m_heap.clear();
+        if (m_pendingContinuations == 0) setActive(false);
+    }
+}
+
+// the pool is only started by the first post, most schedulers never need one
+void Scheduler::post(SmallFunction<>&& job) {
+    std::call_once(m_poolOnce, [this] {
+        m_pool = std::make_unique<WorkerPool>(std::clamp<size_t>(std::thread::hardware_concurrency() / 2, 1, 4));
+    });
+    m_pool->post(std::move(job));
+}
+
+void Scheduler::completeOnMain(SmallFunction<>&& continuation) {
+    std::lock_guard lock(m_completedMutex);
+    m_completed.push_back(std::move(continuation));
+}
+
+void Scheduler::runCompleted() {
+    {
+        std::lock_guard lock(m_completedMutex);
+        if (m_completed.empty()) return;
+        m_running.swap(m_completed);
+    }
+
+    m_pendingContinuations -= m_running.size();
+    for (auto& continuation : m_running) {
+        continuation();
     }
+    m_running.clear();
+}
+
+void Scheduler::push(Handle handle, Clock::time_point due) {
+    m_heap.push_back({due, handle});
+    std::push_heap(m_heap.begin(), m_heap.end(), std::greater<>());
 }
 
-$execute {
-    CCScheduler::get()->scheduleUpdateForTarget(Scheduler::get(), INT_MIN, false);
-}
\ No newline at end of file
+void Scheduler::setActive(bool active) {
+    if (m_active == active) return;
+    m_active = active;
+
+    if (active) CCScheduler::get()->scheduleUpdateForTarget(this, INT_MIN, false);
+    else CCScheduler::get()->unscheduleUpdateForTarget(this);
+}
+
+/*
+    Everything due is popped before anything runs, so per frame tasks rescheduled for "now" wait for the
+    next frame and callbacks are free to schedule or unschedule. Heap entries for unscheduled or rescheduled
+    handles are dropped lazily when they surface.
+*/
+void Scheduler::update(float) {
+    TraceSpan span("scheduler", "Scheduler::update");
+
+    runCompleted();
+
+    auto now = Clock::now();
+
+    m_due.clear();
+    while (!m_heap.empty() && m_heap.front().due <= now) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<>());
+        m_due.push_back(m_heap.back());
+        m_heap.pop_back();
+    }
+
+    for (const auto& entry : m_due) {
+        auto iter = m_scheduledMethods.find(entry.handle);
+        if (iter == m_scheduledMethods.end() || iter->second.due != entry.due) continue;
+
+        auto& task = iter->second;
+        long long missed = 0;
+        if (task.interval > Clock::duration::zero()) {
+            missed = (now - task.due) / task.interval;
+        }
+
+        int runs = task.overrun == Overrun::CatchUp ? static_cast<int>(std::min<long long>(missed + 1, kMaxCatchUp)) : 1;
+        auto handle = entry.handle;
+
+        // moved out while it runs so a callback that unschedules itself doesn't destroy the lambda it's in
+        auto method = std::move(task.method);
+        for (int i = 0; i < runs && method; i++) {
+            method();
+            if (!m_scheduledMethods.contains(handle)) break;
+        }
+
+        iter = m_scheduledMethods.find(handle);
+        if (iter == m_scheduledMethods.end()) continue;
+        iter->second.method = std::move(method);
+
+        // runs past the catch up cap aren't dropped, the task stays due and works through them next frame
+        auto& current = iter->second;
+        if (current.interval > Clock::duration::zero()) {
+            current.due += current.interval * (current.overrun == Overrun::CatchUp ? runs : missed + 1);
+        }
+        else {
+            current.due = now;
+        }
+        push(handle, current.due);
+    }
+
+    if (m_scheduledMethods.empty()) {
+        m_heap.clear();
+        if (m_pendingContinuations == 0) setActive(false);
+    }
+}
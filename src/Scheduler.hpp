@@ -1,39 +1,110 @@
 #pragma once
 
 #include <Geode/cocos/base_nodes/CCNode.h>
+#include <atomic>
 #include <chrono>
-#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
+#include "SmallFunction.hpp"
+#include "WorkerPool.hpp"
+
+// what to do when a task is due more than once by the time the frame gets to it
+enum class Overrun {
+    // run once and move on to the next interval after now
+    Skip,
+    // run once for each missed interval, up to Scheduler::kMaxCatchUp per frame and the rest on the frames after
+    CatchUp
+};
 
 struct ScheduledMethod {
-    std::function<void()> method = nullptr;
-    long long interval = 0;
-    long long elapsedTime = 0;
+    SmallFunction<> method;
+    std::chrono::steady_clock::duration interval{};
+    std::chrono::steady_clock::time_point due;
+    Overrun overrun = Overrun::Skip;
 };
 
+/*
+    Runs callbacks on the main thread from a min heap keyed on the monotonic clock, so intervals don't drift
+    with frame times. Only hooked into CCScheduler while something is scheduled. Main thread only, apart from
+    post, which can be called from anywhere.
+
+    Blocking work goes to a small worker pool through post. postThenMain hands the job's result to a
+    continuation on the main thread, all continuations that finished since the last frame run together.
+*/
 class Scheduler : public cocos2d::CCNode {
 public:
+    using Handle = uint64_t;
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int kMaxCatchUp = 8;
+
     static Scheduler* get();
     static Scheduler* create();
 
     template <class R, class P>
-    void schedule(const std::string& id, std::function<void()>&& method, std::chrono::duration<R, P> interval) {
-        m_scheduledMethods[id] = {
-            std::move(method),
-            std::chrono::duration_cast<std::chrono::milliseconds>(interval).count()
-        };
+    Handle schedule(SmallFunction<>&& method, std::chrono::duration<R, P> interval, Overrun overrun = Overrun::Skip) {
+        return add(std::move(method), std::chrono::duration_cast<Clock::duration>(interval), overrun);
     }
 
-    void schedule(const std::string& id, std::function<void()>&& method) {
-        m_scheduledMethods[id] = {
-            std::move(method),
-            0
-        };
+    // runs every frame
+    Handle schedule(SmallFunction<>&& method) {
+        return add(std::move(method), Clock::duration::zero(), Overrun::Skip);
     }
 
-    void unschedule(const std::string& id);
+    void unschedule(Handle handle);
+
+    void post(SmallFunction<>&& job);
+
+    template <class Job, class Continuation>
+    void postThenMain(Job&& job, Continuation&& continuation) {
+        m_pendingContinuations++;
+        setActive(true);
+
+        post([this, job = std::forward<Job>(job), continuation = std::forward<Continuation>(continuation)]() mutable {
+            if constexpr (std::is_void_v<std::invoke_result_t<Job&>>) {
+                job();
+                completeOnMain([continuation = std::move(continuation)]() mutable {
+                    continuation();
+                });
+            }
+            else {
+                completeOnMain([continuation = std::move(continuation), result = job()]() mutable {
+                    continuation(std::move(result));
+                });
+            }
+        });
+    }
 
     void update(float dt);
 private:
-    std::unordered_map<std::string, ScheduledMethod> m_scheduledMethods;
-};
\ No newline at end of file
+    struct HeapEntry {
+        Clock::time_point due;
+        Handle handle;
+
+        bool operator>(const HeapEntry& other) const {
+            return due > other.due;
+        }
+    };
+
+    Handle add(SmallFunction<>&& method, Clock::duration interval, Overrun overrun);
+    void push(Handle handle, Clock::time_point due);
+    void setActive(bool active);
+    void completeOnMain(SmallFunction<>&& continuation);
+    void runCompleted();
+
+    std::unordered_map<Handle, ScheduledMethod> m_scheduledMethods;
+    std::vector<HeapEntry> m_heap;
+    std::vector<HeapEntry> m_due;
+    Handle m_nextHandle = 1;
+    bool m_active = false;
+
+    std::once_flag m_poolOnce;
+    std::unique_ptr<WorkerPool> m_pool;
+    std::mutex m_completedMutex;
+    std::vector<SmallFunction<>> m_completed;
+    std::vector<SmallFunction<>> m_running;
+    size_t m_pendingContinuations = 0;
+};
@@ -0,0 +1,110 @@
+#include <Geode/Geode.hpp>
+#include "SessionDirectory.hpp"
+#include "Config.hpp"
+#include "FlightRecorder.hpp"
+#include "Utils.hpp"
+
+using namespace geode::prelude;
+
+SessionDirectory* SessionDirectory::get() {
+    static SessionDirectory instance;
+    return &instance;
+}
+
+std::filesystem::path SessionDirectory::resolveBasePath() {
+    std::error_code ec;
+    const char* runtimeEnv = std::getenv("XDG_RUNTIME_DIR");
+    if (runtimeEnv && runtimeEnv[0] == '/' && std::filesystem::is_directory(runtimeEnv, ec)) return runtimeEnv;
+    if (std::filesystem::is_directory("/dev/shm", ec)) return "/dev/shm";
+    return "/tmp";
+}
+
+// /tmp is always included so directories from before the move to RAM get cleaned up too
+std::vector<std::filesystem::path> SessionDirectory::getBasePaths() {
+    std::vector<std::filesystem::path> paths;
+
+    const char* runtimeEnv = std::getenv("XDG_RUNTIME_DIR");
+    if (runtimeEnv && runtimeEnv[0] == '/') paths.emplace_back(runtimeEnv);
+    paths.emplace_back("/dev/shm");
+    paths.emplace_back("/tmp");
+
+    return paths;
+}
+
+void SessionDirectory::setup() {
+    sobriety::utils::createTempDir();
+    renewLease();
+
+    m_leaseTimer = Reactor::get()->addTimer(kLeaseInterval, [this] {
+        renewLease();
+    });
+}
+
+void SessionDirectory::renewLease() {
+    auto now = std::chrono::system_clock::now();
+    auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+
+    auto res = utils::file::writeString(Config::get()->getUniquePath() / "session.lease", fmt::format("{}", nowMs));
+    if (!res) log::error("Failed to renew session lease");
+}
+
+/*
+    Meant to run off the main thread. A session is only removed once its lease has expired and it has been
+    gone for longer than the retention setting. Directories from older versions without a lease fall back
+    to when they were last modified.
+*/
+void SessionDirectory::collect() {
+    auto now = std::chrono::system_clock::now();
+    auto retention = std::max<std::chrono::system_clock::duration>(
+        std::chrono::hours(Config::get()->getSessionRetention()),
+        kLeaseTimeout
+    );
+
+    auto& current = Config::get()->getSessionName();
+    size_t removed = 0;
+
+    for (auto& base : getBasePaths()) {
+        std::error_code iterEc;
+        for (auto it = std::filesystem::directory_iterator(base, iterEc); !iterEc && it != std::filesystem::directory_iterator(); it.increment(iterEc)) {
+            std::error_code ec;
+            auto& entry = *it;
+            auto name = utils::string::pathToString(entry.path().filename());
+            if (name == current || !name.starts_with("GeometryDash-") || name.size() == 13) continue;
+            if (!std::all_of(name.begin() + 13, name.end(), [](char c) { return c >= '0' && c <= '9'; })) continue;
+            if (!entry.is_directory(ec)) continue;
+
+            std::chrono::system_clock::time_point lastAlive;
+            auto keepFor = retention;
+            auto leaseRes = utils::file::readString(entry.path() / "session.lease");
+            if (leaseRes) {
+                auto leaseMs = utils::numFromString<int64_t>(utils::string::trim(leaseRes.unwrap())).unwrapOr(0);
+                lastAlive = std::chrono::system_clock::time_point(std::chrono::milliseconds(leaseMs));
+            }
+            else {
+                auto modified = std::filesystem::last_write_time(entry.path(), ec);
+                if (ec) continue;
+                lastAlive = std::chrono::clock_cast<std::chrono::system_clock>(modified);
+                // nothing says these are finished, a running game from an older version doesn't touch its directory
+                keepFor = std::max<std::chrono::system_clock::duration>(retention, std::chrono::hours(24));
+            }
+
+            if (now - lastAlive >= kLeaseTimeout) exportCrash(entry.path());
+            if (now - lastAlive < keepFor) continue;
+
+            std::filesystem::remove_all(entry.path(), ec);
+            if (!ec) removed++;
+        }
+    }
+
+    if (removed > 0) log::info("Removed {} stale session directories", removed);
+}
+
+void SessionDirectory::exportCrash(const std::filesystem::path& session) {
+    std::error_code ec;
+    auto out = session / "crash.log";
+    if (std::filesystem::exists(out, ec) || !std::filesystem::exists(session / "flight.bin", ec)) return;
+
+    if (FlightRecorder::exportCrash(session / "flight.bin", out)) {
+        log::warn("A previous session crashed, its last log lines are in {}", utils::string::pathToString(out));
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <vector>
+#include "Reactor.hpp"
+
+/*
+    Session directories live on a RAM backed filesystem when there is one, so heartbeats and log writes never
+    touch the disk. Each session keeps a lease file with the last time it was alive, which lets later launches
+    tell a crashed or closed session apart from one that's still running and clean it up.
+*/
+class SessionDirectory {
+public:
+    static constexpr auto kLeaseInterval = std::chrono::minutes(1);
+    // a session that missed this many refreshes is considered gone
+    static constexpr auto kLeaseTimeout = kLeaseInterval * 3;
+
+    static SessionDirectory* get();
+
+    static std::filesystem::path resolveBasePath();
+    static std::vector<std::filesystem::path> getBasePaths();
+
+    void setup();
+    void collect();
+
+private:
+    void renewLease();
+    void exportCrash(const std::filesystem::path& session);
+
+    Reactor::Id m_leaseTimer = 0;
+};
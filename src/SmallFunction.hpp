@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*
+    A move only void() callable that keeps small captures inline, so scheduling a lambda that holds a pointer
+    or two doesn't allocate. Anything bigger than the buffer falls back to the heap.
+*/
+template <size_t Size = 48>
+class SmallFunction {
+public:
+    SmallFunction() = default;
+    SmallFunction(std::nullptr_t) {}
+
+    template <class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, SmallFunction>>>
+    SmallFunction(F&& func) {
+        using T = std::decay_t<F>;
+        if constexpr (sizeof(T) <= Size && alignof(T) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<T>) {
+            new (&m_storage) T(std::forward<F>(func));
+            m_ops = &s_inlineOps<T>;
+        }
+        else {
+            *reinterpret_cast<T**>(&m_storage) = new T(std::forward<F>(func));
+            m_ops = &s_heapOps<T>;
+        }
+    }
+
+    SmallFunction(SmallFunction&& other) noexcept {
+        moveFrom(other);
+    }
+
+    SmallFunction& operator=(SmallFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    SmallFunction(const SmallFunction&) = delete;
+    SmallFunction& operator=(const SmallFunction&) = delete;
+
+    ~SmallFunction() {
+        reset();
+    }
+
+    void operator()() {
+        m_ops->invoke(&m_storage);
+    }
+
+    explicit operator bool() const {
+        return m_ops != nullptr;
+    }
+
+    void reset() {
+        if (m_ops) m_ops->destroy(&m_storage);
+        m_ops = nullptr;
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void*);
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void*);
+    };
+
+    template <class T>
+    static constexpr Ops s_inlineOps = {
+        [](void* p) { (*static_cast<T*>(p))(); },
+        [](void* dst, void* src) {
+            new (dst) T(std::move(*static_cast<T*>(src)));
+            static_cast<T*>(src)->~T();
+        },
+        [](void* p) { static_cast<T*>(p)->~T(); }
+    };
+
+    template <class T>
+    static constexpr Ops s_heapOps = {
+        [](void* p) { (**static_cast<T**>(p))(); },
+        [](void* dst, void* src) { *static_cast<T**>(dst) = *static_cast<T**>(src); },
+        [](void* p) { delete *static_cast<T**>(p); }
+    };
+
+    void moveFrom(SmallFunction& other) {
+        m_ops = other.m_ops;
+        if (m_ops) m_ops->move(&m_storage, &other.m_storage);
+        other.m_ops = nullptr;
+    }
+
+    alignas(std::max_align_t) std::byte m_storage[Size];
+    const Ops* m_ops = nullptr;
+};
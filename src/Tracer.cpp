@@ -0,0 +1,173 @@
+#include <Geode/Geode.hpp>
+#include "Tracer.hpp"
+#include "Config.hpp"
+#include "FlightRecorder.hpp"
+#include "Utils.hpp"
+
+using namespace geode::prelude;
+
+Tracer* Tracer::get() {
+    static Tracer instance;
+    return &instance;
+}
+
+void Tracer::setup() {
+    if (!Config::get()->shouldTrace()) return;
+
+    sobriety::utils::createTempDir();
+    auto path = Config::get()->getUniquePath() / "trace.json";
+    m_file = CreateFileW(
+        path.c_str(),
+        GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_DELETE,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (m_file == INVALID_HANDLE_VALUE) return log::error("Failed to create trace file: {}", GetLastError());
+
+    m_processId = GetCurrentProcessId();
+    DWORD written = 0;
+    WriteFile(m_file, "[\n", 2, &written, nullptr);
+
+    s_enabled.store(true, std::memory_order_relaxed);
+    m_flushTimer = Reactor::get()->addTimer(std::chrono::duration_cast<std::chrono::milliseconds>(kFlushInterval), [this] {
+        flush();
+    });
+}
+
+/*
+    Each thread registers its buffer the first time it records something. The tracer keeps a reference too,
+    so events from threads that have already exited still get written out.
+*/
+Tracer::ThreadBuffer* Tracer::getThreadBuffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (buffer) return buffer.get();
+
+    buffer = std::make_shared<ThreadBuffer>();
+    buffer->events.reserve(1024);
+    buffer->threadId = GetCurrentThreadId();
+    buffer->threadName = thread::getName();
+
+    std::lock_guard lock(m_buffersMutex);
+    m_buffers.push_back(buffer);
+    return buffer.get();
+}
+
+void Tracer::record(const Event& event) {
+    if (event.phase == Phase::Complete) {
+        FlightRecorder::get()->recordTrace(event.category, event.name, event.duration);
+    }
+    auto buffer = getThreadBuffer();
+
+    std::lock_guard lock(buffer->mutex);
+    if (buffer->events.size() >= kMaxBufferedEvents) {
+        buffer->dropped++;
+        return;
+    }
+    buffer->events.push_back(event);
+}
+
+void Tracer::instant(const char* category, const char* name) {
+    if (!isEnabled()) return;
+    record({category, name, Phase::Instant, now(), 0, 0});
+}
+
+void Tracer::asyncBegin(const char* category, const char* name, uint64_t id) {
+    if (!isEnabled()) return;
+    record({category, name, Phase::AsyncBegin, now(), 0, id});
+}
+
+void Tracer::asyncEnd(const char* category, const char* name, uint64_t id) {
+    if (!isEnabled()) return;
+    record({category, name, Phase::AsyncEnd, now(), 0, id});
+}
+
+void Tracer::flush() {
+    if (!isEnabled()) return;
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard lock(m_buffersMutex);
+        buffers = m_buffers;
+    }
+
+    std::lock_guard lock(m_flushMutex);
+    for (auto& buffer : buffers) {
+        size_t dropped;
+        {
+            std::lock_guard bufferLock(buffer->mutex);
+            m_events.swap(buffer->events);
+            dropped = std::exchange(buffer->dropped, 0);
+        }
+
+        if (!buffer->named) {
+            buffer->named = true;
+            std::string name;
+            for (char c : buffer->threadName) {
+                if (c == '"' || c == '\\') name += '\\';
+                name += c;
+            }
+            fmt::format_to(std::back_inserter(m_output),
+                "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":{},\"tid\":{},\"args\":{{\"name\":\"{}\"}}}},\n",
+                m_processId, buffer->threadId, name
+            );
+        }
+
+        for (auto& event : m_events) {
+            appendEvent(event, buffer->threadId);
+        }
+        if (dropped > 0) {
+            fmt::format_to(std::back_inserter(m_output),
+                "{{\"name\":\"events dropped\",\"cat\":\"tracer\",\"ph\":\"i\",\"s\":\"t\",\"ts\":{},\"pid\":{},\"tid\":{},\"args\":{{\"count\":{}}}}},\n",
+                now(), m_processId, buffer->threadId, dropped
+            );
+        }
+        m_events.clear();
+    }
+
+    buffers.clear();
+    {
+        // a buffer only the tracer holds belongs to a thread that has exited, and it was just written out
+        std::lock_guard lock(m_buffersMutex);
+        std::erase_if(m_buffers, [](const std::shared_ptr<ThreadBuffer>& buffer) {
+            return buffer.use_count() == 1 && buffer->events.empty();
+        });
+    }
+
+    if (m_output.empty()) return;
+
+    std::string_view data = m_output;
+    while (!data.empty()) {
+        DWORD written = 0;
+        if (!WriteFile(m_file, data.data(), static_cast<DWORD>(data.size()), &written, nullptr) || written == 0) break;
+        data.remove_prefix(written);
+    }
+    m_output.clear();
+}
+
+void Tracer::appendEvent(const Event& event, DWORD threadId) {
+    auto out = std::back_inserter(m_output);
+    switch (event.phase) {
+        case Phase::Complete: {
+            fmt::format_to(out, "{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{},\"dur\":{},\"pid\":{},\"tid\":{}}},\n",
+                event.name, event.category, event.timestamp, event.duration, m_processId, threadId
+            );
+            break;
+        }
+        case Phase::Instant: {
+            fmt::format_to(out, "{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"i\",\"s\":\"t\",\"ts\":{},\"pid\":{},\"tid\":{}}},\n",
+                event.name, event.category, event.timestamp, m_processId, threadId
+            );
+            break;
+        }
+        case Phase::AsyncBegin:
+        case Phase::AsyncEnd: {
+            fmt::format_to(out, "{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"{}\",\"id\":\"{:#x}\",\"ts\":{},\"pid\":{},\"tid\":{}}},\n",
+                event.name, event.category, static_cast<char>(event.phase), event.id, event.timestamp, m_processId, threadId
+            );
+            break;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Reactor.hpp"
+
+/*
+    Events go into a buffer owned by the thread that recorded them and the reactor moves them out once a
+    second, appending them to trace.json in the session directory. The file uses the trace event array format
+    without a closing bracket, which trace viewers accept, so a crash still leaves a readable trace.
+
+    With tracing off, a span costs one relaxed load. Names and categories must be string literals.
+*/
+class Tracer {
+public:
+    static constexpr size_t kMaxBufferedEvents = 1 << 16;
+    static constexpr auto kFlushInterval = std::chrono::seconds(1);
+
+    enum class Phase : char {
+        Complete = 'X',
+        Instant = 'i',
+        AsyncBegin = 'b',
+        AsyncEnd = 'e'
+    };
+
+    struct Event {
+        const char* category;
+        const char* name;
+        Phase phase;
+        // microseconds
+        int64_t timestamp;
+        int64_t duration;
+        uint64_t id;
+    };
+
+    static Tracer* get();
+
+    static bool isEnabled() {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+
+    void setup();
+    void flush();
+
+    void record(const Event& event);
+    void instant(const char* category, const char* name);
+    void asyncBegin(const char* category, const char* name, uint64_t id);
+    void asyncEnd(const char* category, const char* name, uint64_t id);
+
+private:
+    struct ThreadBuffer {
+        std::mutex mutex;
+        std::vector<Event> events;
+        size_t dropped = 0;
+        DWORD threadId = 0;
+        std::string threadName;
+        bool named = false;
+    };
+
+    ThreadBuffer* getThreadBuffer();
+    void appendEvent(const Event& event, DWORD threadId);
+
+    static inline std::atomic<bool> s_enabled = false;
+
+    std::mutex m_buffersMutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+
+    std::mutex m_flushMutex;
+    std::vector<Event> m_events;
+    std::string m_output;
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    DWORD m_processId = 0;
+    Reactor::Id m_flushTimer = 0;
+};
+
+class TraceSpan {
+public:
+    TraceSpan(const char* category, const char* name)
+        : m_category(category), m_name(name), m_start(Tracer::isEnabled() ? Tracer::now() : -1) {}
+
+    ~TraceSpan() {
+        if (m_start < 0) return;
+        Tracer::get()->record({m_category, m_name, Tracer::Phase::Complete, m_start, Tracer::now() - m_start, 0});
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* m_category;
+    const char* m_name;
+    int64_t m_start;
+};
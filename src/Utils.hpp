@@ -1,10 +1,13 @@
 #pragma once
 
 #include "Config.hpp"
+#include "PathTranslator.hpp"
+#include <Geode/Result.hpp>
 #include <Geode/loader/Log.hpp>
 #include <Geode/loader/Types.hpp>
 #include <filesystem>
 #include <minwindef.h>
+#include <namedpipeapi.h>
 #include <processthreadsapi.h>
 #include <string>
 
@@ -31,7 +34,46 @@ namespace sobriety::utils {
         }
     }
 
-    static void runCommand(const std::string& cmd) {
+    /*
+        Scripts are named after a hash of their contents and kept in the mod's save directory, which unlike /tmp
+        nobody else can write to. A name match alone says nothing about what's inside, so an existing script is
+        read back and only reused when it matches exactly. Falls back to the session directory if the save
+        directory isn't writable.
+    */
+    static geode::Result<std::filesystem::path> emitScript(std::string_view name, std::string_view script) {
+        uint64_t hash = 0xcbf29ce484222325;
+        for (unsigned char c : script) {
+            hash ^= c;
+            hash *= 0x100000001b3;
+        }
+
+        auto fileName = fmt::format("{}-{:016x}.exe", name, hash);
+        auto path = Config::get()->getScriptPath() / fileName;
+
+        auto existing = geode::utils::file::readString(path);
+        if (existing && existing.unwrap() == script) return geode::Ok(path);
+
+        // written under a temporary name first so another instance never runs a half written script
+        auto tmpPath = Config::get()->getScriptPath() / fmt::format("{}.{}.tmp", fileName, GetCurrentProcessId());
+        if (geode::utils::file::createDirectoryAll(Config::get()->getScriptPath())
+            && geode::utils::file::writeString(tmpPath, std::string(script))
+            && MoveFileExW(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+            return geode::Ok(path);
+        }
+        std::error_code ec;
+        std::filesystem::remove(tmpPath, ec);
+
+        path = Config::get()->getUniquePath() / fmt::format("{}.exe", name);
+        auto res = geode::utils::file::writeString(path, std::string(script));
+        if (!res) return geode::Err("Failed to write {} script: {}", name, res.unwrapErr());
+        return geode::Ok(path);
+    }
+
+    /*
+        Returns the process handle when wine gives us one, the caller owns it. Native linux programs started
+        through wine's unix spawn path come back without one, so callers need a fallback.
+    */
+    static geode::Result<HANDLE> spawnProcess(const std::string& cmd, HANDLE stdOutput = nullptr) {
         STARTUPINFOA si{};
         PROCESS_INFORMATION pi{};
 
@@ -39,21 +81,70 @@ namespace sobriety::utils {
         si.dwFlags = STARTF_USESHOWWINDOW;
         si.wShowWindow = SW_HIDE;
 
+        if (stdOutput) {
+            si.dwFlags |= STARTF_USESTDHANDLES;
+            si.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+            si.hStdOutput = stdOutput;
+            si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+        }
+
         if (!CreateProcessA(
                 nullptr,
                 const_cast<char*>(cmd.c_str()),
                 nullptr, nullptr,
-                FALSE,
+                stdOutput ? TRUE : FALSE,
                 CREATE_NO_WINDOW,
                 nullptr,
                 nullptr,
                 &si,
                 &pi
             )) {
-        } else {
-            CloseHandle(pi.hProcess);
-            CloseHandle(pi.hThread);
+            return geode::Err("Failed to start process: {}", GetLastError());
         }
+
+        if (pi.hThread) CloseHandle(pi.hThread);
+        return geode::Ok(pi.hProcess);
+    }
+
+    static void runCommand(const std::string& cmd) {
+        if (auto process = spawnProcess(cmd).unwrapOr(nullptr)) CloseHandle(process);
+    }
+
+    /*
+        Blocks until the command and everything that inherited its stdout have exited, so only call this
+        off the main thread. EOF on the pipe is the completion signal, wine doesn't give us a usable process
+        handle for native programs.
+    */
+    static geode::Result<std::string> runCommandForOutput(const std::string& cmd) {
+        SECURITY_ATTRIBUTES sa{};
+        sa.nLength = sizeof(sa);
+        sa.bInheritHandle = TRUE;
+
+        HANDLE readPipe = nullptr;
+        HANDLE writePipe = nullptr;
+        if (!CreatePipe(&readPipe, &writePipe, &sa, 0)) {
+            return geode::Err("Failed to create pipe: {}", GetLastError());
+        }
+        SetHandleInformation(readPipe, HANDLE_FLAG_INHERIT, 0);
+
+        auto processRes = spawnProcess(cmd, writePipe);
+        CloseHandle(writePipe);
+
+        if (!processRes) {
+            CloseHandle(readPipe);
+            return geode::Err(processRes.unwrapErr());
+        }
+        if (auto process = processRes.unwrap()) CloseHandle(process);
+
+        std::string output;
+        char buffer[4096];
+        DWORD read = 0;
+        while (ReadFile(readPipe, buffer, sizeof(buffer), &read, nullptr) && read > 0) {
+            output.append(buffer, read);
+        }
+        CloseHandle(readPipe);
+
+        return geode::Ok(std::move(output));
     }
 
     static bool isWine() {
@@ -73,48 +164,6 @@ namespace sobriety::utils {
         the path I passed in like some nerd, so I build it as a string instead.
     */
     static std::string wineToLinuxPath(const std::filesystem::path& winPath) {
-        std::string s = geode::utils::string::pathToString(winPath);
-
-        if (s.size() < 2 || s[1] != ':')
-            return s;
-
-        char drive = std::tolower(s[0]);
-        std::string rest = s.substr(2);
-        for (auto& c : rest) if (c == '\\') c = '/';
-
-        const char* prefixEnv = std::getenv("WINEPREFIX");
-        const char* homeEnv = std::getenv("HOME");
-
-        std::string prefix;
-        if (prefixEnv) {
-            prefix = prefixEnv;
-        } else if (homeEnv) {
-            prefix = std::string(homeEnv) + "/.wine";
-        } else {
-            prefix = "/.wine";
-        }
-
-        std::string drivePath;
-
-        if (drive == 'z') {
-            drivePath = "/";
-        } else {
-            drivePath = prefix + "/drive_" + drive;
-        }
-
-        std::string fullPath = drivePath;
-        size_t start = 0;
-        while (start < rest.size()) {
-            size_t end = rest.find('/', start);
-            if (end == std::string::npos) end = rest.size();
-            std::string part = rest.substr(start, end - start);
-            if (!part.empty()) {
-                if (fullPath.back() != '/') fullPath += "/";
-                fullPath += part;
-            }
-            start = end + 1;
-        }
-
-        return fullPath;
+        return PathTranslator::get()->toLinux(winPath);
     }
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include <Geode/Geode.hpp>
+#include "Watchdog.hpp"
+#include "Config.hpp"
+#include "Metrics.hpp"
+#include "Tracer.hpp"
+
+using namespace geode::prelude;
+
+Watchdog* Watchdog::get() {
+    static Watchdog instance;
+    return &instance;
+}
+
+static int64_t toMicroseconds(Watchdog::Clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+}
+
+void Watchdog::setup() {
+    m_threshold = std::chrono::milliseconds(Config::get()->getStallThreshold());
+    if (m_threshold.count() <= 0) return;
+
+    for (size_t i = 0; i < kPercentiles.size(); i++) {
+        Metrics::get()->observe("sobriety_frame_window_seconds", "Frame time percentiles over the last full window", [this, i] {
+            return m_windowPercentiles[i].load(std::memory_order_relaxed);
+        }, {{"quantile", fmt::format("{}", kPercentiles[i] / 100)}});
+    }
+
+    auto interval = std::clamp(m_threshold / 4, std::chrono::milliseconds(10), std::chrono::milliseconds(250));
+    m_pollTimer = Reactor::get()->addTimer(interval, [this] {
+        poll();
+    });
+}
+
+// the director going away looks just like a hang from here
+void Watchdog::stop() {
+    if (m_pollTimer == 0) return;
+    Reactor::get()->remove(m_pollTimer);
+    m_pollTimer = 0;
+}
+
+void Watchdog::frame() {
+    if (m_threshold.count() <= 0) return;
+
+    static auto& frameTime = Metrics::get()->histogram("sobriety_frame_seconds", "Time between frames on the main thread");
+    static auto& stalls = Metrics::get()->counter("sobriety_main_thread_stalls_total", "Frames that took longer than the stall threshold");
+    static auto& stallTime = Metrics::get()->histogram("sobriety_main_thread_stall_seconds", "How long each stalled frame took");
+
+    auto now = Clock::now();
+    m_frameAt.store(toMicroseconds(now), std::memory_order_relaxed);
+    m_frame.fetch_add(1, std::memory_order_release);
+
+    if (m_lastFrame == Clock::time_point{}) {
+        m_lastFrame = now;
+        m_windowStart = now;
+        return;
+    }
+
+    auto gap = now - m_lastFrame;
+    m_lastFrame = now;
+    frameTime.record(gap);
+    m_window.record(gap);
+
+    if (gap >= m_threshold) {
+        auto ms = std::chrono::duration<double, std::milli>(gap).count();
+        stalls.add();
+        stallTime.record(gap);
+        if (Tracer::isEnabled()) {
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(gap).count();
+            Tracer::get()->record({"watchdog", "stall", Tracer::Phase::Complete, Tracer::now() - duration, duration, 0});
+        }
+
+        m_hangReported.store(false, std::memory_order_relaxed);
+        log::warn("Main thread stalled for {:.0f}ms", ms);
+    }
+
+    if (now - m_windowStart >= kWindow) {
+        for (size_t i = 0; i < kPercentiles.size(); i++) {
+            m_windowPercentiles[i].store(m_window.getPercentile(kPercentiles[i]) / 1e6, std::memory_order_relaxed);
+        }
+        m_window.reset();
+        m_windowStart = now;
+    }
+}
+
+/*
+    Only the start of a hang is logged from here, its length is logged by the frame that ends it. Nothing is
+    checked until the first frame, loading before that is allowed to take as long as it likes.
+*/
+void Watchdog::poll() {
+    auto frame = m_frame.load(std::memory_order_acquire);
+    if (frame == 0) return;
+    if (frame != m_seenFrame) {
+        m_seenFrame = frame;
+        return;
+    }
+
+    auto since = std::chrono::microseconds(toMicroseconds(Clock::now()) - m_frameAt.load(std::memory_order_relaxed));
+    if (since < m_threshold || m_hangReported.exchange(true, std::memory_order_relaxed)) return;
+
+    log::warn("Main thread hasn't drawn a frame in {}ms", std::chrono::duration_cast<std::chrono::milliseconds>(since).count());
+}
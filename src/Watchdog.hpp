@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include "LatencyHistogram.hpp"
+#include "Reactor.hpp"
+
+/*
+    Watches the game's own main thread the way the heartbeat watches the console. Every frame stamps a counter,
+    and the reactor checks it a few times per threshold. A frame that takes longer than the stall threshold is
+    logged with its length once it finishes, and a frame that still hasn't finished by then is logged while it
+    hangs, so a freeze that never comes back still leaves a line in the log and the flight recorder.
+
+    Frame times also go into a histogram that starts over every kWindow, the last full window's percentiles
+    are exported as gauges next to the all time summary.
+*/
+class Watchdog {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr auto kWindow = std::chrono::seconds(10);
+    static constexpr std::array<double, 4> kPercentiles = {50, 95, 99, 100};
+
+    static Watchdog* get();
+
+    void setup();
+    void stop();
+    // main thread, once per frame
+    void frame();
+
+private:
+    void poll();
+
+    std::chrono::milliseconds m_threshold{};
+    Reactor::Id m_pollTimer = 0;
+
+    // written by the main thread, read by the reactor
+    std::atomic<uint64_t> m_frame = 0;
+    std::atomic<int64_t> m_frameAt = 0;
+    std::atomic<bool> m_hangReported = false;
+
+    // reactor only
+    uint64_t m_seenFrame = 0;
+
+    // main thread only
+    Clock::time_point m_lastFrame;
+    Clock::time_point m_windowStart;
+    LatencyHistogram m_window;
+    std::array<std::atomic<double>, kPercentiles.size()> m_windowPercentiles{};
+};
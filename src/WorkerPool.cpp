@@ -0,0 +1,89 @@
+#include <Geode/Geode.hpp>
+#include "WorkerPool.hpp"
+
+using namespace geode::prelude;
+
+thread_local WorkerPool* WorkerPool::t_pool = nullptr;
+thread_local size_t WorkerPool::t_index = 0;
+
+WorkerPool::WorkerPool(size_t workers) {
+    workers = std::max<size_t>(workers, 1);
+    for (size_t i = 0; i < workers; i++) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < workers; i++) {
+        m_threads.emplace_back([this, i] {
+            thread::setName(fmt::format("Sobriety Worker {}", i));
+            t_pool = this;
+            t_index = i;
+            run(i);
+        });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_sleepCv.notify_all();
+    for (auto& thread : m_threads) {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+void WorkerPool::post(SmallFunction<>&& job) {
+    bool local = t_pool == this;
+    size_t index = local ? t_index : m_next.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+
+    {
+        auto& queue = *m_queues[index];
+        std::lock_guard lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+    m_queued.fetch_add(1, std::memory_order_release);
+
+    {
+        std::lock_guard lock(m_sleepMutex);
+    }
+    m_sleepCv.notify_one();
+}
+
+bool WorkerPool::pop(size_t index, SmallFunction<>& job) {
+    {
+        auto& own = *m_queues[index];
+        std::lock_guard lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < m_queues.size(); i++) {
+        auto& victim = *m_queues[(index + i) % m_queues.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::run(size_t index) {
+    SmallFunction<> job;
+    while (true) {
+        if (pop(index, job)) {
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            job();
+            job.reset();
+            continue;
+        }
+
+        std::unique_lock lock(m_sleepMutex);
+        m_sleepCv.wait(lock, [this] { return m_stop || m_queued.load(std::memory_order_acquire) > 0; });
+        if (m_stop) return;
+    }
+}
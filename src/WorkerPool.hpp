@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "SmallFunction.hpp"
+
+/*
+    A small work stealing pool. Each worker has its own deque, jobs posted from a worker go to the back of its
+    own queue and idle workers steal from the front of the others, so bursts spread out without one shared lock.
+*/
+class WorkerPool {
+public:
+    WorkerPool(size_t workers);
+    ~WorkerPool();
+
+    void post(SmallFunction<>&& job);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<SmallFunction<>> jobs;
+    };
+
+    void run(size_t index);
+    bool pop(size_t index, SmallFunction<>& job);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::atomic<size_t> m_next = 0;
+    std::atomic<size_t> m_queued = 0;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_sleepCv;
+    bool m_stop = false;
+
+    static thread_local WorkerPool* t_pool;
+    static thread_local size_t t_index;
+};
@@ -1,35 +1,103 @@
 #include <Geode/Geode.hpp>
 #include <Geode/modify/MenuLayer.hpp>
 #include <Geode/modify/CCDirector.hpp>
+#include "Benchmark.hpp"
 #include "Config.hpp"
 #include "FileExplorer.hpp"
 #include "Console.hpp"
+#include "Metrics.hpp"
+#include "PathTranslator.hpp"
+#include "Profiler.hpp"
+#include "SessionDirectory.hpp"
+#include "Tracer.hpp"
 #include "Utils.hpp"
+#include "Watchdog.hpp"
 
 using namespace geode::prelude;
 
+static double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+/*
+    Only hooks and the log sink are set up on the loader thread, anything that has to go through wine to
+    reach linux (resolving drives, spawning the console) happens on a startup thread so the game isn't held up.
+*/
 $execute {
+    auto start = std::chrono::steady_clock::now();
+
+    Tracer::get()->setup();
+    SessionDirectory::get()->setup();
+    Metrics::get()->setup();
+    Watchdog::get()->setup();
+    Profiler::get()->setup();
     FileExplorer::get()->setup();
     Console::get()->setup();
+
+    std::thread([start] {
+        thread::setName("Sobriety Startup");
+
+        auto drivesStart = std::chrono::steady_clock::now();
+        PathTranslator::get()->setup();
+        auto drivesMs = elapsedMs(drivesStart);
+
+        auto consoleStart = std::chrono::steady_clock::now();
+        Console::get()->start();
+        auto consoleMs = elapsedMs(consoleStart);
+
+        SessionDirectory::get()->collect();
+
+        log::info("Background startup finished {:.2f}ms after launch (drives {:.2f}ms, console {:.2f}ms)",
+            elapsedMs(start), drivesMs, consoleMs
+        );
+
+        // after startup so the path benchmarks see resolved drives
+        if (sobriety::benchmark::isEnabled()) sobriety::benchmark::run();
+    }).detach();
+
+    log::info("Startup added {:.2f}ms to game launch", elapsedMs(start));
+}
+
+/*
+    Both ways out of the game end up here. The sink is flushed before the exit file is written, since the
+    console closes as soon as it sees it and would take the shutdown summary with it.
+
+    if writing the exit file fails, the console wont exit, it shouldn't fail, but if it does, it isn't a big deal, as the user can close it themselves still
+    imo a skill issue if writing to /tmp fails for any of these.
+*/
+static bool onGameExit() {
+    Watchdog::get()->stop();
+    Profiler::get()->stop();
+    Metrics::get()->snapshot();
+    Metrics::get()->logSummary();
+    Tracer::get()->flush();
+
+    auto sink = Console::get()->getLogSink();
+    if (sink) sink->flushAndWait();
+
+    auto exitPath = Config::get()->getUniquePath() / "console.exit";
+    if (!utils::file::writeString(exitPath, "")) {
+        log::error("Failed to create console exit file");
+        if (sink) sink->flushAndWait();
+        return false;
+    }
+    return true;
 }
 
 class $modify(CCDirector) {
+    void drawScene() {
+        Watchdog::get()->frame();
+        CCDirector::drawScene();
+    }
+
     void purgeDirector() {
-        /*
-            if this fails, the console wont exit, it shouldn't fail, but if it does, it isn't a big deal, as the user can close it themselves still
-            imo a skill issue if writing to /tmp fails for any of these.
-        */
-        auto exitPath = Config::get()->getUniquePath() / "console.exit";
-        auto exitRes = utils::file::writeString(exitPath, "");
-        if (!exitRes) return log::error("Failed to create console exit file");
+        if (!onGameExit()) return;
         CCDirector::purgeDirector();
     }
 };
 
 void geode_utils_game_exit_h(bool saveData) {
-    auto exitPath = Config::get()->getUniquePath() / "console.exit";
-    auto exitRes = utils::file::writeString(exitPath, "");
-    if (!exitRes) return log::error("Failed to create console exit file");
+    if (!onGameExit()) return;
     geode::utils::game::exit(saveData);
 }
 